@@ -0,0 +1,77 @@
+#include "async_search.h"
+
+#include <chrono>
+#include <utility>
+
+AsyncSearch::~AsyncSearch() {
+    stop();
+}
+
+template <int Size>
+void AsyncSearch::start(const BasicGomokuGame<Size> &game, int ai_player, int human_player, AiDifficulty difficulty,
+                        AiSearchOptions options) {
+    stop();
+    cancel_.reset();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        best_ = AiSearchResult{};
+        best_.move = {Size / 2, Size / 2};
+        done_ = false;
+    }
+    options.cancel = &cancel_;
+    std::function<void(const AiSearchResult &)> user_callback = std::move(options.on_iteration);
+    options.on_iteration = [this, user_callback](const AiSearchResult &progress) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            best_ = progress;
+        }
+        if (user_callback) {
+            user_callback(progress);
+        }
+    };
+    worker_ = std::thread([this, game, ai_player, human_player, difficulty, options]() {
+        AiSearchResult result = SearchAiMove(game, ai_player, human_player, difficulty, options);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            best_ = result;
+            done_ = true;
+        }
+        finished_.notify_all();
+    });
+}
+
+bool AsyncSearch::done() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return done_;
+}
+
+AiSearchResult AsyncSearch::best() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return best_;
+}
+
+bool AsyncSearch::wait(int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!worker_.joinable()) {
+        return done_;
+    }
+    if (timeout_ms < 0) {
+        finished_.wait(lock, [this]() { return done_; });
+    } else {
+        finished_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]() { return done_; });
+    }
+    return done_;
+}
+
+AiSearchResult AsyncSearch::stop() {
+    if (worker_.joinable()) {
+        cancel_.cancel();
+        worker_.join();
+    }
+    return best();
+}
+
+#define GOMOKU_INSTANTIATE(N)                                                                           \
+    template void AsyncSearch::start(const BasicGomokuGame<N> &, int, int, AiDifficulty, AiSearchOptions);
+GOMOKU_FOR_EACH_BOARD_SIZE(GOMOKU_INSTANTIATE)
+#undef GOMOKU_INSTANTIATE
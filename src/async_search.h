@@ -0,0 +1,57 @@
+#ifndef GOMOKU_ASYNC_SEARCH_H
+#define GOMOKU_ASYNC_SEARCH_H
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "gomoku.h"
+#include "gomoku_ai.h"
+
+// Runs SearchAiMove on a worker thread over a snapshot of the position, so
+// the caller stays responsive. The caller polls best() or waits, and may
+// stop the search at any time to play its best move so far. One search at
+// a time; not itself thread-safe, except that best() and done() may be
+// called from any thread.
+class AsyncSearch {
+public:
+    AsyncSearch() = default;
+    ~AsyncSearch();
+
+    AsyncSearch(const AsyncSearch &) = delete;
+    AsyncSearch &operator=(const AsyncSearch &) = delete;
+
+    // Stops any running search, then starts a new one. The options' cancel
+    // token is replaced by this object's; an on_iteration callback is still
+    // called. Objects the options point to (table, stats, book, cache) must
+    // outlive the search, and stats must not be read until it is done.
+    template <int Size>
+    void start(const BasicGomokuGame<Size> &game, int ai_player, int human_player, AiDifficulty difficulty,
+               AiSearchOptions options);
+
+    // A search was started and its result has not been collected by stop().
+    bool running() const { return worker_.joinable(); }
+    // The running search has finished on its own or after a cancel.
+    bool done() const;
+    // The final result once done; before that the deepest completed
+    // iteration so far. Until the first completes depth is 0 and the move
+    // is not meaningful; stop() always yields a legal move.
+    AiSearchResult best() const;
+
+    // Waits up to timeout_ms (forever when negative) for the search to
+    // finish; returns done().
+    bool wait(int timeout_ms = -1);
+    // Cancels the search, waits for it and returns its result. Without a
+    // running search it returns the last result.
+    AiSearchResult stop();
+
+private:
+    std::thread worker_;
+    CancellationToken cancel_;
+    mutable std::mutex mutex_;
+    std::condition_variable finished_;
+    AiSearchResult best_;
+    bool done_ = false;
+};
+
+#endif
@@ -0,0 +1,148 @@
+#include "batch_eval.h"
+
+#include <algorithm>
+
+#include "gomoku_ai.h"
+#include "gomoku_eval.h"
+
+namespace {
+
+// Positions claimed at a time; large enough to keep the shared counter cold.
+constexpr std::size_t kChunk = 32;
+
+} // namespace
+
+template <int Size>
+BasicPackedPosition<Size> BasicPackedPosition<Size>::pack(const BasicGomokuGame<Size> &game) {
+    BasicPackedPosition position;
+    for (int y = 0; y < Size; ++y) {
+        for (int x = 0; x < Size; ++x) {
+            position.set(x, y, game.at(x, y));
+        }
+    }
+    position.setToMove(game.currentPlayer());
+    return position;
+}
+
+template <int Size>
+void BasicPackedPosition<Size>::unpack(BasicGomokuGame<Size> &game) const {
+    game.reset();
+    for (int i = 0; i < kWordCount; ++i) {
+        std::uint64_t word = words_[i];
+        if (i == kWordCount - 1) {
+            word &= ~(1ULL << 63);
+        }
+        std::uint64_t pending = word;
+        while (pending != 0) {
+            int bit = bitboard::CountTrailingZeros(pending) & ~1;
+            pending &= ~(3ULL << bit);
+            int cell = (i * 64 + bit) / 2;
+            int player = static_cast<int>((word >> bit) & 3);
+            if (player == GomokuGame::kBlack || player == GomokuGame::kWhite) {
+                game.placeStone(cell % Size, cell / Size, player);
+            }
+        }
+    }
+    game.setCurrentPlayer(toMove());
+}
+
+template <int Size>
+struct BasicBatchEvaluator<Size>::Scratch {
+    BasicGomokuGame<Size> game;
+    BasicIncrementalEvaluator<Size> eval;
+};
+
+template <int Size>
+BasicBatchEvaluator<Size>::BasicBatchEvaluator(int threads) {
+    if (threads <= 0) {
+        threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    for (int i = 0; i < threads; ++i) {
+        scratch_.push_back(std::make_unique<Scratch>());
+    }
+    for (int i = 1; i < threads; ++i) {
+        helpers_.emplace_back(&BasicBatchEvaluator::runHelper, this, i);
+    }
+}
+
+template <int Size>
+BasicBatchEvaluator<Size>::~BasicBatchEvaluator() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        quit_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread &helper : helpers_) {
+        helper.join();
+    }
+}
+
+template <int Size>
+void BasicBatchEvaluator<Size>::evaluate(const Position *positions, std::size_t count, PositionEval *results) {
+    positions_ = positions;
+    results_ = results;
+    count_ = count;
+    next_.store(0, std::memory_order_relaxed);
+    // A batch that one chunk covers is not worth waking anyone for.
+    if (helpers_.empty() || count <= kChunk) {
+        drain(*scratch_.front());
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++generation_;
+        busy_ = static_cast<int>(helpers_.size());
+    }
+    wake_.notify_all();
+    drain(*scratch_.front());
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_.wait(lock, [this]() { return busy_ == 0; });
+}
+
+template <int Size>
+void BasicBatchEvaluator<Size>::runHelper(int index) {
+    std::uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&]() { return quit_ || generation_ != seen; });
+            if (quit_) {
+                return;
+            }
+            seen = generation_;
+        }
+        drain(*scratch_[index]);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--busy_ == 0) {
+            finished_.notify_one();
+        }
+    }
+}
+
+template <int Size>
+void BasicBatchEvaluator<Size>::drain(Scratch &scratch) {
+    for (;;) {
+        std::size_t begin = next_.fetch_add(kChunk, std::memory_order_relaxed);
+        if (begin >= count_) {
+            return;
+        }
+        std::size_t end = std::min(begin + kChunk, count_);
+        for (std::size_t i = begin; i < end; ++i) {
+            positions_[i].unpack(scratch.game);
+            int player = scratch.game.currentPlayer();
+            int opponent = player == GomokuGame::kBlack ? GomokuGame::kWhite : GomokuGame::kBlack;
+            scratch.eval.reset(scratch.game);
+            PositionEval &result = results_[i];
+            result.score = scratch.eval.score(player, opponent);
+            result.move = scratch.game.isBoardFull()
+                              ? std::pair<int, int>{-1, -1}
+                              : ComputeAiMove(scratch.game, player, opponent, AiDifficulty::Normal);
+        }
+    }
+}
+
+#define GOMOKU_INSTANTIATE(N)              \
+    template class BasicPackedPosition<N>; \
+    template class BasicBatchEvaluator<N>;
+GOMOKU_FOR_EACH_BOARD_SIZE(GOMOKU_INSTANTIATE)
+#undef GOMOKU_INSTANTIATE
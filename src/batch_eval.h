@@ -0,0 +1,104 @@
+#ifndef GOMOKU_BATCH_EVAL_H
+#define GOMOKU_BATCH_EVAL_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gomoku.h"
+
+// A position packed two bits per cell, row-major: 0 empty, 1 black, 2
+// white. The side to move is the top bit of the last word, which no cell
+// reaches, so a 15x15 position is 64 bytes. Only the stones are kept, not
+// the order they were played in.
+template <int Size>
+class BasicPackedPosition {
+public:
+    static constexpr int kWordCount = (Size * Size * 2 + 63) / 64;
+    static_assert(Size * Size * 2 < kWordCount * 64, "no spare bit for the side to move");
+
+    int at(int x, int y) const {
+        int bit = (y * Size + x) * 2;
+        return static_cast<int>((words_[bit / 64] >> (bit % 64)) & 3);
+    }
+    void set(int x, int y, int player) {
+        int bit = (y * Size + x) * 2;
+        std::uint64_t &word = words_[bit / 64];
+        word = (word & ~(3ULL << (bit % 64))) | (static_cast<std::uint64_t>(player) << (bit % 64));
+    }
+    int toMove() const { return (words_[kWordCount - 1] >> 63) != 0 ? GomokuGame::kWhite : GomokuGame::kBlack; }
+    void setToMove(int player) {
+        std::uint64_t white = player == GomokuGame::kWhite ? 1 : 0;
+        words_[kWordCount - 1] = (words_[kWordCount - 1] & ~(1ULL << 63)) | (white << 63);
+    }
+
+    static BasicPackedPosition pack(const BasicGomokuGame<Size> &game);
+    // Resets game, places the stones row by row and sets the side to move.
+    void unpack(BasicGomokuGame<Size> &game) const;
+
+private:
+    std::array<std::uint64_t, kWordCount> words_{};
+};
+
+using PackedPosition = BasicPackedPosition<GomokuGame::kBoardSize>;
+
+struct PositionEval {
+    // Static evaluation for the side to move: its IncrementalEvaluator
+    // total minus the opponent's.
+    int score = 0;
+    // The Normal move, the best candidate by static scoring; {-1, -1} on a
+    // full board.
+    std::pair<int, int> move{-1, -1};
+};
+
+// Static evaluation of many positions at once, for offline analysis. The
+// calling thread and threads - 1 helpers, started once, take chunks of the
+// batch in turn. Each keeps its own game and evaluator, so nothing is
+// allocated per position. One batch at a time.
+template <int Size>
+class BasicBatchEvaluator {
+public:
+    using Position = BasicPackedPosition<Size>;
+
+    // threads <= 0 uses every hardware thread.
+    explicit BasicBatchEvaluator(int threads = 0);
+    ~BasicBatchEvaluator();
+
+    BasicBatchEvaluator(const BasicBatchEvaluator &) = delete;
+    BasicBatchEvaluator &operator=(const BasicBatchEvaluator &) = delete;
+
+    // results[i] is the evaluation of positions[i]. Blocks until all are done.
+    void evaluate(const Position *positions, std::size_t count, PositionEval *results);
+
+    int threadCount() const { return static_cast<int>(scratch_.size()); }
+
+private:
+    struct Scratch;
+
+    void runHelper(int index);
+    void drain(Scratch &scratch);
+
+    std::vector<std::unique_ptr<Scratch>> scratch_;
+    std::vector<std::thread> helpers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable finished_;
+    std::uint64_t generation_ = 0;
+    int busy_ = 0;
+    bool quit_ = false;
+    const Position *positions_ = nullptr;
+    PositionEval *results_ = nullptr;
+    std::size_t count_ = 0;
+    std::atomic<std::size_t> next_{0};
+};
+
+using BatchEvaluator = BasicBatchEvaluator<GomokuGame::kBoardSize>;
+
+#endif
@@ -0,0 +1,749 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "batch_eval.h"
+#include "engine_host.h"
+#include "eval_kernel.h"
+#include "gomoku.h"
+#include "gomoku_ai.h"
+#include "gomoku_eval.h"
+#include "opening_book.h"
+
+// Engine benchmarks over a fixed corpus. Every benchmark is run --repeat
+// times and the median is reported, as JSON on stdout (or --out). With
+// --baseline the run is also compared against an earlier JSON file and the
+// exit code is 1 when anything slowed down by more than --threshold percent.
+// --check-allocations instead checks that searching allocates nothing once
+// the search is set up.
+namespace {
+
+using BenchClock = std::chrono::steady_clock;
+
+// Heap allocations made through operator new, counted by the replacement
+// below. Over-aligned allocations are not counted; only tables make them.
+std::atomic<std::uint64_t> g_allocations{0};
+
+struct CorpusPosition {
+    const char *name;
+    const char *moves;
+};
+
+// Openings, midgames from engine self-play, and tactical positions in which
+// the side to move has a forced win by fours.
+const CorpusPosition kCorpus[] = {
+    {"opening-1", "7,7"},
+    {"opening-2", "7,7 8,8"},
+    {"opening-3", "7,7 8,8 6,8"},
+    {"midgame-1", "7,7 8,8 6,8 9,5 4,10 5,9 6,7 9,7 6,6 6,9 6,4 6,5 5,7 4,7"},
+    {"midgame-2", "7,7 7,8 8,6 6,8 10,4 9,5 8,8 8,7 6,6 5,5 9,9 10,10 9,6 7,6"},
+    {"midgame-3", "7,7 8,7 6,6 8,8 4,4 5,5 8,6 7,6 6,8 9,5 5,9 4,10 6,5 6,7 5,8 5,7 6,4 6,2 5,3 7,5 4,8 3,8 7,4 "
+                  "5,4"},
+    {"midgame-4", "7,7 6,8 8,8 5,5 10,10 9,9 8,7 5,7 8,6 8,9 8,4 8,5 9,7 10,7 7,9 10,6 6,10 5,11 7,5 10,8 5,3 6,4 "
+                  "10,5 7,8"},
+    {"tactical-1", "7,7 8,8 6,8 9,5 4,10 5,9 6,7 9,7 6,6 6,9 6,4 6,5 5,7 4,7 7,9 4,6 8,10 9,11 7,5 4,8"},
+    {"tactical-2", "7,7 7,8 8,6 6,8 10,4 9,5 8,8 8,7 6,6 5,5 9,9 10,10 9,6 7,6 6,5 6,4 9,8 9,7 3,7 7,3 5,7"},
+    {"tactical-3", "7,7 8,6 9,8 8,7 8,8 7,8 9,9 6,6 11,11 10,10 9,6 9,7 10,8 12,8 11,7 8,10 12,6 13,5 9,11 9,10 "
+                   "11,10 6,10 7,10 11,9 10,11 12,11 8,11 7,11 9,12 12,9"},
+};
+
+struct BenchOptions {
+    bool check_allocations = false;
+    // 0 runs the normal benchmarks; otherwise the thread-scaling sweep to
+    // this depth.
+    int scaling_depth = 0;
+    int repeat = 5;
+    int min_ms = 100;
+    double threshold = 10.0;
+    std::string filter;
+    std::string out_path;
+    std::string baseline_path;
+};
+
+struct BenchResult {
+    std::string name;
+    double ns_per_op = 0.0;
+    std::uint64_t ops = 0;
+    std::uint64_t nodes = 0;
+    // Heap allocations made by one search.
+    std::uint64_t allocations = 0;
+    std::string move;
+    // Hard only, from one extra run with statistics enabled.
+    bool has_stats = false;
+    double branching = 0.0;
+    double first_cutoff = 0.0;
+    // Batch benchmarks, where an op is one position.
+    double positions_per_sec = 0.0;
+    // Host benchmarks, where an op is one request.
+    bool has_latency = false;
+    double p50_ms = 0.0;
+    double p99_ms = 0.0;
+    // Scaling entries, where an op is one corpus position.
+    double nodes_per_sec = 0.0;
+    double speedup = 0.0;
+};
+
+// Keeps benchmarked results observable so the work is not optimized away.
+std::uint64_t g_sink = 0;
+
+// offset shifts every move, to centre a corpus position on a larger board.
+template <int Size>
+bool LoadPosition(const char *moves, BasicGomokuGame<Size> &game, int offset = 0) {
+    game.reset();
+    std::istringstream stream(moves);
+    std::string token;
+    int player = GomokuGame::kBlack;
+    while (stream >> token) {
+        int x = 0;
+        int y = 0;
+        if (std::sscanf(token.c_str(), "%d,%d", &x, &y) != 2 || !game.placeStone(x + offset, y + offset, player)) {
+            return false;
+        }
+        player = player == GomokuGame::kBlack ? GomokuGame::kWhite : GomokuGame::kBlack;
+    }
+    game.setCurrentPlayer(player);
+    return true;
+}
+
+double Median(std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+// Runs body (which returns the number of operations it performed) until
+// min_ms has elapsed, repeat times, and records the median cost per op.
+BenchResult RunMicro(const std::string &name, const BenchOptions &options, const std::function<std::uint64_t()> &body) {
+    BenchResult result;
+    result.name = name;
+    std::vector<double> samples;
+    for (int r = 0; r < options.repeat; ++r) {
+        std::uint64_t ops = 0;
+        auto start = BenchClock::now();
+        auto deadline = start + std::chrono::milliseconds(options.min_ms);
+        BenchClock::time_point now;
+        do {
+            ops += body();
+            now = BenchClock::now();
+        } while (now < deadline);
+        samples.push_back(std::chrono::duration<double, std::nano>(now - start).count() / static_cast<double>(ops));
+        result.ops = ops;
+    }
+    result.ns_per_op = Median(samples);
+    return result;
+}
+
+template <int Size>
+BenchResult RunSearch(const std::string &name, const BenchOptions &options, const BasicGomokuGame<Size> &game,
+                      AiDifficulty difficulty, TranspositionTable &table) {
+    BenchResult result;
+    result.name = name;
+    result.ops = 1;
+    int ai_player = game.currentPlayer();
+    int human_player = ai_player == GomokuGame::kBlack ? GomokuGame::kWhite : GomokuGame::kBlack;
+    AiSearchOptions search;
+    search.tt = &table;
+    std::vector<double> samples;
+    for (int r = 0; r < options.repeat; ++r) {
+        table.clear();
+        std::uint64_t allocations = g_allocations.load(std::memory_order_relaxed);
+        auto start = BenchClock::now();
+        AiSearchResult found = SearchAiMove(game, ai_player, human_player, difficulty, search);
+        samples.push_back(std::chrono::duration<double, std::nano>(BenchClock::now() - start).count());
+        result.allocations = g_allocations.load(std::memory_order_relaxed) - allocations;
+        result.nodes = found.nodes;
+        result.move = std::to_string(found.move.first) + "," + std::to_string(found.move.second);
+    }
+    result.ns_per_op = Median(samples);
+
+    if (difficulty == AiDifficulty::Hard) {
+        SearchStats stats;
+        search.stats = &stats;
+        table.clear();
+        SearchAiMove(game, ai_player, human_player, difficulty, search);
+        result.has_stats = true;
+        result.branching = stats.effectiveBranchingFactor();
+        result.first_cutoff = stats.firstMoveCutoffRate();
+    }
+    return result;
+}
+
+// Hard on the corpus midgames, centred on a larger board.
+template <int Size>
+void RunBoardSize(const BenchOptions &options, const std::function<bool(const std::string &)> &selected,
+                  TranspositionTable &table, std::vector<BenchResult> &results) {
+    for (const auto &position : kCorpus) {
+        std::string name = "search/hard/board" + std::to_string(Size) + "-" + position.name;
+        if (std::string(position.name).rfind("midgame", 0) != 0 || !selected(name)) {
+            continue;
+        }
+        BasicGomokuGame<Size> game;
+        if (!LoadPosition(position.moves, game, (Size - GomokuGame::kBoardSize) / 2)) {
+            std::fprintf(stderr, "corpus position %s is invalid\n", position.name);
+            std::exit(1);
+        }
+        results.push_back(RunSearch(name, options, game, AiDifficulty::Hard, table));
+    }
+}
+
+std::vector<BenchResult> RunAll(const BenchOptions &options) {
+    std::vector<GomokuGame> games;
+    std::vector<std::string> names;
+    for (const auto &position : kCorpus) {
+        GomokuGame game;
+        if (!LoadPosition(position.moves, game)) {
+            std::fprintf(stderr, "corpus position %s is invalid\n", position.name);
+            std::exit(1);
+        }
+        games.push_back(game);
+        names.push_back(position.name);
+    }
+    std::function<bool(const std::string &)> selected = [&](const std::string &name) {
+        return options.filter.empty() || name.find(options.filter) != std::string::npos;
+    };
+
+    std::vector<BenchResult> results;
+    TranspositionTable table;
+    const std::pair<const char *, AiDifficulty> difficulties[] = {
+        {"easy", AiDifficulty::Easy}, {"normal", AiDifficulty::Normal}, {"hard", AiDifficulty::Hard}};
+    for (const auto &difficulty : difficulties) {
+        for (std::size_t i = 0; i < games.size(); ++i) {
+            std::string name = std::string("search/") + difficulty.first + "/" + names[i];
+            if (selected(name)) {
+                results.push_back(RunSearch(name, options, games[i], difficulty.second, table));
+            }
+        }
+    }
+    RunBoardSize<19>(options, selected, table, results);
+    RunBoardSize<20>(options, selected, table, results);
+
+    if (selected("micro/find_winning_line")) {
+        results.push_back(RunMicro("micro/find_winning_line", options, [&]() {
+            std::uint64_t ops = 0;
+            for (const auto &game : games) {
+                for (const auto &move : game.moveHistory()) {
+                    g_sink += game.findWinningLine(move.x, move.y, move.player).has_value();
+                    ++ops;
+                }
+            }
+            return ops;
+        }));
+    }
+    if (selected("micro/candidates")) {
+        results.push_back(RunMicro("micro/candidates", options, [&]() {
+            for (const auto &game : games) {
+                game.forEachCandidate([](int x, int y) {
+                    g_sink += static_cast<std::uint64_t>(x + y);
+                });
+            }
+            return static_cast<std::uint64_t>(games.size());
+        }));
+    }
+    if (selected("micro/evaluate_cell")) {
+        results.push_back(RunMicro("micro/evaluate_cell", options, [&]() {
+            std::uint64_t ops = 0;
+            for (const auto &game : games) {
+                game.forEachCandidate([&](int x, int y) {
+                    g_sink += static_cast<std::uint64_t>(EvaluateCell(game, x, y, GomokuGame::kBlack));
+                    g_sink += static_cast<std::uint64_t>(EvaluateCell(game, x, y, GomokuGame::kWhite));
+                    ops += 2;
+                });
+            }
+            return ops;
+        }));
+    }
+    // The batched kernels over the same cells, once per kernel the CPU has.
+    std::vector<std::vector<int>> candidate_cells;
+    for (const auto &game : games) {
+        std::vector<int> cells;
+        game.forEachCandidate([&](int x, int y) {
+            cells.push_back(y * GomokuGame::kBoardSize + x);
+        });
+        candidate_cells.push_back(cells);
+    }
+    const EvalKernel detected_kernel = ActiveEvalKernel();
+    for (EvalKernel kernel : {EvalKernel::Scalar, EvalKernel::Avx2}) {
+        std::string suffix = std::string("/") + EvalKernelName(kernel);
+        bool want_scores = selected("micro/evaluate_cells" + suffix);
+        bool want_threats = selected("micro/classify_cells" + suffix);
+        if ((!want_scores && !want_threats) || !SetEvalKernel(kernel)) {
+            continue;
+        }
+        if (want_scores) {
+            results.push_back(RunMicro("micro/evaluate_cells" + suffix, options, [&]() {
+                std::uint64_t ops = 0;
+                int black[GomokuGame::kCellCount];
+                int white[GomokuGame::kCellCount];
+                for (std::size_t i = 0; i < games.size(); ++i) {
+                    int count = static_cast<int>(candidate_cells[i].size());
+                    if (count == 0) {
+                        continue;
+                    }
+                    EvaluateCellsBoth(games[i], candidate_cells[i].data(), count, black, white);
+                    g_sink += static_cast<std::uint64_t>(black[0] + white[count - 1]);
+                    ops += static_cast<std::uint64_t>(count) * 2;
+                }
+                return ops;
+            }));
+        }
+        if (want_threats) {
+            results.push_back(RunMicro("micro/classify_cells" + suffix, options, [&]() {
+                std::uint64_t ops = 0;
+                CellThreats threats[GomokuGame::kCellCount];
+                for (std::size_t i = 0; i < games.size(); ++i) {
+                    int count = static_cast<int>(candidate_cells[i].size());
+                    if (count == 0) {
+                        continue;
+                    }
+                    ClassifyCells(games[i], candidate_cells[i].data(), count, threats);
+                    g_sink += static_cast<std::uint64_t>(threats[count - 1].black[0]);
+                    ops += static_cast<std::uint64_t>(count) * 2;
+                }
+                return ops;
+            }));
+        }
+    }
+    SetEvalKernel(detected_kernel);
+    if (selected("micro/place_undo")) {
+        results.push_back(RunMicro("micro/place_undo", options, [&]() {
+            // Placing and undoing leaves the candidates as they were, so the
+            // lists built above serve every run.
+            std::uint64_t ops = 0;
+            for (std::size_t i = 0; i < games.size(); ++i) {
+                GomokuGame &game = games[i];
+                for (int cell : candidate_cells[i]) {
+                    game.placeStone(cell % GomokuGame::kBoardSize, cell / GomokuGame::kBoardSize,
+                                    game.currentPlayer());
+                    g_sink += game.hash();
+                    game.undoLastMove();
+                    ++ops;
+                }
+            }
+            return ops;
+        }));
+    }
+    if (selected("micro/evaluator_reset")) {
+        IncrementalEvaluator evaluator;
+        results.push_back(RunMicro("micro/evaluator_reset", options, [&]() {
+            for (const auto &game : games) {
+                evaluator.reset(game);
+                g_sink += static_cast<std::uint64_t>(evaluator.total(GomokuGame::kBlack));
+            }
+            return static_cast<std::uint64_t>(games.size());
+        }));
+    }
+    // Every corpus prefix, repeated into one batch, on one thread and on all.
+    constexpr std::size_t kBatchPositions = 4096;
+    std::vector<PackedPosition> batch;
+    for (const auto &game : games) {
+        GomokuGame prefix;
+        for (const auto &move : game.moveHistory()) {
+            prefix.placeStone(move.x, move.y, move.player);
+            prefix.setCurrentPlayer(move.player == GomokuGame::kBlack ? GomokuGame::kWhite : GomokuGame::kBlack);
+            batch.push_back(PackedPosition::pack(prefix));
+        }
+    }
+    for (std::size_t i = 0; batch.size() < kBatchPositions; ++i) {
+        batch.push_back(batch[i]);
+    }
+    std::vector<PositionEval> evals(batch.size());
+    std::vector<int> thread_counts = {1};
+    if (std::thread::hardware_concurrency() > 1) {
+        thread_counts.push_back(static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    for (int threads : thread_counts) {
+        std::string name = "batch/evaluate/threads-" + std::to_string(threads);
+        if (!selected(name)) {
+            continue;
+        }
+        BatchEvaluator evaluator(threads);
+        BenchResult result = RunMicro(name, options, [&]() {
+            evaluator.evaluate(batch.data(), batch.size(), evals.data());
+            g_sink += static_cast<std::uint64_t>(evals.back().score);
+            return static_cast<std::uint64_t>(batch.size());
+        });
+        result.positions_per_sec = 1e9 / result.ns_per_op;
+        results.push_back(result);
+    }
+    // Every session asks for a Normal move at once, from a corpus position,
+    // so requests queue behind each other as on a busy host.
+    constexpr int kHostSessions = 64;
+    const std::string host_name = "host/sessions-" + std::to_string(kHostSessions);
+    if (selected(host_name)) {
+        HostOptions host_options;
+        host_options.queue_capacity = kHostSessions;
+        EngineHost host(host_options);
+        std::atomic<std::uint64_t> replies{0};
+        int connection = host.connect([&](const std::string &) { replies.fetch_add(1); });
+        for (int i = 0; i < kHostSessions; ++i) {
+            host.handle(connection, "new level normal");
+        }
+        BenchResult result = RunMicro(host_name, options, [&]() {
+            for (int i = 0; i < kHostSessions; ++i) {
+                std::string id = std::to_string(i + 1);
+                host.handle(connection, "position " + id + " " + kCorpus[i % std::size(kCorpus)].moves);
+                host.handle(connection, "go " + id);
+            }
+            host.wait(connection);
+            return static_cast<std::uint64_t>(kHostSessions);
+        });
+        g_sink += replies.load();
+        LatencySummary latency = host.latency();
+        result.has_latency = true;
+        result.p50_ms = latency.p50_ms;
+        result.p99_ms = latency.p99_ms;
+        results.push_back(result);
+        host.disconnect(connection);
+    }
+    if (selected("micro/book_probe")) {
+        // A book of every corpus prefix and the move played from it, probed
+        // at each of those prefixes.
+        OpeningBookWriter writer;
+        std::vector<GomokuGame> prefixes;
+        for (const auto &game : games) {
+            GomokuGame prefix;
+            for (const auto &move : game.moveHistory()) {
+                writer.add(prefix, {move.x, move.y});
+                prefixes.push_back(prefix);
+                prefix.placeStone(move.x, move.y, move.player);
+            }
+        }
+        std::string path = (std::filesystem::temp_directory_path() / "gomoku-bench.book").string();
+        OpeningBook book;
+        if (writer.save(path) && book.open(path)) {
+            results.push_back(RunMicro("micro/book_probe", options, [&]() {
+                std::pair<int, int> move;
+                for (const auto &prefix : prefixes) {
+                    g_sink += book.probe(prefix, move) ? static_cast<std::uint64_t>(move.first) : 0;
+                }
+                return static_cast<std::uint64_t>(prefixes.size());
+            }));
+        } else {
+            std::fprintf(stderr, "cannot write book %s\n", path.c_str());
+        }
+        book.close();
+        std::remove(path.c_str());
+    }
+    return results;
+}
+
+// Setting a search up allocates (worker state, threads); searching must
+// not, so a search to depth 1 and one to kAllocationCheckDepth have to
+// allocate the same, with one and two threads, with and without
+// statistics. The tactical corpus positions are left out: the root threat
+// solver settles them before the first iteration. The quiet positions, from
+// engine self-play, give neither side a forced win within reach, so the
+// search itself runs all the way down. A position that stops short of the
+// depth fails the check too, since it proves nothing.
+constexpr int kAllocationCheckDepth = 5;
+
+const CorpusPosition kQuietPositions[] = {
+    {"quiet-1", "7,7 7,8 8,8 6,6 6,8 8,9 8,6 5,9 10,4 9,5 8,5 6,9"},
+    {"quiet-2", "7,7 7,8 8,8 6,6 6,8 8,9 8,6 5,9 10,4 9,5 8,5 6,9 8,7 8,4"},
+    {"quiet-3", "7,7 7,8 8,8 6,6 6,8 8,9 8,6 5,9 10,4 9,5 8,5 6,9 8,7 8,4 9,9 6,7"},
+};
+
+int CheckAllocations() {
+    std::vector<CorpusPosition> positions;
+    for (const auto &position : kCorpus) {
+        if (std::string(position.name).rfind("tactical", 0) != 0) {
+            positions.push_back(position);
+        }
+    }
+    positions.insert(positions.end(), std::begin(kQuietPositions), std::end(kQuietPositions));
+
+    // The table makes each worker's threat solver on the first search that
+    // needs it and keeps it; one search up front keeps that out of the counts.
+    TranspositionTable table;
+    {
+        AiSearchOptions search;
+        search.tt = &table;
+        search.threads = 2;
+        search.max_depth = 1;
+        SearchAiMove(GomokuGame{}, GomokuGame::kBlack, GomokuGame::kWhite, AiDifficulty::Hard, search);
+    }
+    int failures = 0;
+    std::fprintf(stderr, "%-24s %7s %5s %9s %9s %7s\n", "position", "threads", "stats", "depth 1", "depth 5",
+                 "reached");
+    for (const auto &position : positions) {
+        GomokuGame game;
+        if (!LoadPosition(position.moves, game)) {
+            std::fprintf(stderr, "corpus position %s is invalid\n", position.name);
+            return 2;
+        }
+        int ai_player = game.currentPlayer();
+        int human_player = ai_player == GomokuGame::kBlack ? GomokuGame::kWhite : GomokuGame::kBlack;
+        for (int threads : {1, 2}) {
+            for (bool with_stats : {false, true}) {
+                std::uint64_t counts[2] = {};
+                int reached = 0;
+                for (int i = 0; i < 2; ++i) {
+                    table.clear();
+                    SearchStats stats;
+                    AiSearchOptions search;
+                    search.tt = &table;
+                    search.threads = threads;
+                    search.max_depth = i == 0 ? 1 : kAllocationCheckDepth;
+                    search.stats = with_stats ? &stats : nullptr;
+                    std::uint64_t before = g_allocations.load(std::memory_order_relaxed);
+                    AiSearchResult result = SearchAiMove(game, ai_player, human_player, AiDifficulty::Hard, search);
+                    counts[i] = g_allocations.load(std::memory_order_relaxed) - before;
+                    reached = result.depth;
+                }
+                bool steady = counts[0] == counts[1];
+                bool deep = reached >= kAllocationCheckDepth;
+                failures += steady && deep ? 0 : 1;
+                std::fprintf(stderr, "%-24s %7d %5s %9llu %9llu %7d%s%s\n", position.name, threads,
+                             with_stats ? "yes" : "no", static_cast<unsigned long long>(counts[0]),
+                             static_cast<unsigned long long>(counts[1]), reached, steady ? "" : "  ALLOCATES",
+                             deep ? "" : "  SHALLOW");
+            }
+        }
+    }
+    return failures > 0 ? 1 : 0;
+}
+
+// Lazy SMP scaling: Hard searches of the corpus openings and midgames to a
+// fixed depth at each thread count. Time to depth is the main thread's time
+// to complete that iteration, summed over the positions (median of the
+// repeats for each); nodes/sec counts every worker's nodes.
+std::vector<BenchResult> RunScaling(const BenchOptions &options) {
+    constexpr int kThreadCounts[] = {1, 2, 4, 8, 16};
+    std::vector<GomokuGame> games;
+    for (const auto &position : kCorpus) {
+        GomokuGame game;
+        if (std::string(position.name).rfind("tactical", 0) == 0) {
+            continue;
+        }
+        if (!LoadPosition(position.moves, game)) {
+            std::fprintf(stderr, "corpus position %s is invalid\n", position.name);
+            std::exit(1);
+        }
+        games.push_back(game);
+    }
+    TranspositionTable table(64);
+    std::vector<BenchResult> results;
+    std::fprintf(stderr, "%7s %16s %14s %8s\n", "threads", "time_to_depth_ms", "nodes_per_sec", "speedup");
+    for (int threads : kThreadCounts) {
+        BenchResult result;
+        result.name = "scaling/depth-" + std::to_string(options.scaling_depth) + "/threads-" + std::to_string(threads);
+        result.ops = games.size();
+        double total_ms = 0.0;
+        std::uint64_t total_nodes = 0;
+        double time_to_depth_ns = 0.0;
+        for (const GomokuGame &game : games) {
+            int ai_player = game.currentPlayer();
+            int human_player = ai_player == GomokuGame::kBlack ? GomokuGame::kWhite : GomokuGame::kBlack;
+            std::vector<double> samples;
+            for (int r = 0; r < options.repeat; ++r) {
+                table.clear();
+                SearchStats stats;
+                AiSearchOptions search;
+                search.tt = &table;
+                search.threads = threads;
+                search.max_depth = options.scaling_depth;
+                search.stats = &stats;
+                AiSearchResult found = SearchAiMove(game, ai_player, human_player, AiDifficulty::Hard, search);
+                double reached_ms = found.elapsed_ms;
+                for (const SearchIterationStats &iteration : stats.iterations) {
+                    if (iteration.depth == options.scaling_depth) {
+                        reached_ms = iteration.elapsed_ms;
+                    }
+                }
+                samples.push_back(reached_ms * 1e6);
+                total_ms += found.elapsed_ms;
+                total_nodes += found.nodes;
+            }
+            time_to_depth_ns += Median(samples);
+        }
+        result.ns_per_op = time_to_depth_ns / static_cast<double>(games.size());
+        result.nodes_per_sec = total_ms > 0.0 ? static_cast<double>(total_nodes) / total_ms * 1000.0 : 0.0;
+        result.speedup = results.empty() ? 1.0 : results.front().ns_per_op / result.ns_per_op;
+        std::fprintf(stderr, "%7d %16.1f %14.0f %7.2fx\n", threads, time_to_depth_ns / 1e6, result.nodes_per_sec,
+                     result.speedup);
+        results.push_back(result);
+    }
+    return results;
+}
+
+void WriteJson(std::FILE *out, const BenchOptions &options, const std::vector<BenchResult> &results) {
+    std::fprintf(out, "{\n  \"schema\": 1,\n  \"repeat\": %d,\n  \"min_ms\": %d,\n  \"benchmarks\": [\n",
+                 options.repeat, options.min_ms);
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const BenchResult &result = results[i];
+        std::fprintf(out, "    {\"name\": \"%s\", \"ns_per_op\": %.1f, \"ops\": %llu", result.name.c_str(),
+                     result.ns_per_op, static_cast<unsigned long long>(result.ops));
+        if (!result.move.empty()) {
+            std::fprintf(out, ", \"nodes\": %llu, \"allocations\": %llu, \"move\": \"%s\"",
+                         static_cast<unsigned long long>(result.nodes),
+                         static_cast<unsigned long long>(result.allocations), result.move.c_str());
+        }
+        if (result.has_stats) {
+            std::fprintf(out, ", \"branching\": %.2f, \"first_cutoff\": %.3f", result.branching, result.first_cutoff);
+        }
+        if (result.positions_per_sec > 0.0) {
+            std::fprintf(out, ", \"positions_per_sec\": %.0f", result.positions_per_sec);
+        }
+        if (result.has_latency) {
+            std::fprintf(out, ", \"p50_ms\": %.3f, \"p99_ms\": %.3f", result.p50_ms, result.p99_ms);
+        }
+        if (result.nodes_per_sec > 0.0) {
+            std::fprintf(out, ", \"nodes_per_sec\": %.0f, \"speedup\": %.2f", result.nodes_per_sec, result.speedup);
+        }
+        std::fprintf(out, "}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ],\n  \"checksum\": %llu\n}\n", static_cast<unsigned long long>(g_sink));
+}
+
+// Reads name -> ns_per_op from a file written by WriteJson. This is not a
+// general JSON parser; it relies on each benchmark being one line.
+bool ReadBaseline(const std::string &path, std::map<std::string, double> &baseline) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        std::size_t name_at = line.find("\"name\": \"");
+        std::size_t cost_at = line.find("\"ns_per_op\": ");
+        if (name_at == std::string::npos || cost_at == std::string::npos) {
+            continue;
+        }
+        name_at += 9;
+        std::size_t name_end = line.find('"', name_at);
+        if (name_end == std::string::npos) {
+            continue;
+        }
+        baseline[line.substr(name_at, name_end - name_at)] = std::atof(line.c_str() + cost_at + 13);
+    }
+    return true;
+}
+
+int CompareWithBaseline(const BenchOptions &options, const std::vector<BenchResult> &results) {
+    std::map<std::string, double> baseline;
+    if (!ReadBaseline(options.baseline_path, baseline)) {
+        std::fprintf(stderr, "cannot read baseline %s\n", options.baseline_path.c_str());
+        return 2;
+    }
+    int regressions = 0;
+    std::fprintf(stderr, "%-36s %14s %14s %9s\n", "benchmark", "baseline ns", "current ns", "change");
+    for (const auto &result : results) {
+        auto it = baseline.find(result.name);
+        if (it == baseline.end() || it->second <= 0.0) {
+            std::fprintf(stderr, "%-36s %14s %14.1f %9s\n", result.name.c_str(), "-", result.ns_per_op, "new");
+            continue;
+        }
+        double change = (result.ns_per_op / it->second - 1.0) * 100.0;
+        bool regressed = change > options.threshold;
+        regressions += regressed ? 1 : 0;
+        std::fprintf(stderr, "%-36s %14.1f %14.1f %+8.1f%%%s\n", result.name.c_str(), it->second, result.ns_per_op,
+                     change, regressed ? "  REGRESSION" : "");
+    }
+    return regressions > 0 ? 1 : 0;
+}
+
+void PrintUsage(const char *program) {
+    std::fprintf(stderr,
+                 "usage: %s [options]\n"
+                 "  --filter TEXT       only run benchmarks whose name contains TEXT\n"
+                 "  --repeat N          runs per benchmark, median reported (default 5)\n"
+                 "  --min-ms N          minimum time per micro-benchmark run (default 100)\n"
+                 "  --out FILE          write JSON to FILE instead of stdout\n"
+                 "  --baseline FILE     compare against an earlier JSON result\n"
+                 "  --threshold PCT     slowdown that counts as a regression (default 10)\n"
+                 "  --check-allocations only check that searches allocate nothing past setup\n"
+                 "  --scaling DEPTH     only sweep Hard search threads 1-16 to DEPTH: time to depth and nodes/sec\n",
+                 program);
+}
+
+bool ParseArguments(int argc, char **argv, BenchOptions &options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--check-allocations") {
+            options.check_allocations = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char *value = argv[++i];
+        if (arg == "--filter") {
+            options.filter = value;
+        } else if (arg == "--repeat") {
+            options.repeat = std::max(1, std::atoi(value));
+        } else if (arg == "--min-ms") {
+            options.min_ms = std::max(1, std::atoi(value));
+        } else if (arg == "--out") {
+            options.out_path = value;
+        } else if (arg == "--baseline") {
+            options.baseline_path = value;
+        } else if (arg == "--threshold") {
+            options.threshold = std::atof(value);
+        } else if (arg == "--scaling") {
+            options.scaling_depth = std::max(1, std::atoi(value));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+void *operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+int main(int argc, char **argv) {
+    BenchOptions options;
+    if (!ParseArguments(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+    if (options.check_allocations) {
+        return CheckAllocations();
+    }
+
+    std::vector<BenchResult> results = options.scaling_depth > 0 ? RunScaling(options) : RunAll(options);
+
+    std::FILE *out = stdout;
+    if (!options.out_path.empty()) {
+        out = std::fopen(options.out_path.c_str(), "w");
+        if (out == nullptr) {
+            std::fprintf(stderr, "cannot write %s\n", options.out_path.c_str());
+            return 2;
+        }
+    }
+    WriteJson(out, options, results);
+    if (out != stdout) {
+        std::fclose(out);
+    }
+
+    if (!options.baseline_path.empty()) {
+        return CompareWithBaseline(options, results);
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+#ifndef GOMOKU_BITBOARD_H
+#define GOMOKU_BITBOARD_H
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Line words pack one board line into a 64-bit integer, two bits per lane.
+// Lanes hold kLaneEmpty, a player id (1 or 2) or kLaneWall. Every line is
+// padded with kLinePadding wall lanes on both ends so that windows around any
+// on-board cell can be read without bounds checks.
+namespace bitboard {
+
+constexpr int kLinePadding = 5;
+constexpr std::uint64_t kLaneEmpty = 0;
+constexpr std::uint64_t kLaneWall = 3;
+constexpr std::uint64_t kLaneLowBits = 0x5555555555555555ULL;
+
+constexpr int kDirections[4][2] = {
+    {1, 0}, {0, 1}, {1, 1}, {1, -1}
+};
+
+inline int CountTrailingZeros(std::uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward64(&index, value);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+inline int CountLeadingZeros(std::uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanReverse64(&index, value);
+    return 63 - static_cast<int>(index);
+#else
+    return __builtin_clzll(value);
+#endif
+}
+
+inline int PopCount(std::uint64_t value) {
+#if defined(_MSC_VER)
+    return static_cast<int>(__popcnt64(value));
+#else
+    return __builtin_popcountll(value);
+#endif
+}
+
+inline int LaneAt(std::uint64_t word, int lane) {
+    return static_cast<int>((word >> (lane * 2)) & 3);
+}
+
+// Returns a mask with the low bit of every lane owned by player set.
+inline std::uint64_t OwnedLanes(std::uint64_t word, int player) {
+    std::uint64_t low = word & kLaneLowBits;
+    std::uint64_t high = (word >> 1) & kLaneLowBits;
+    return player == 1 ? (low & ~high) : (high & ~low);
+}
+
+// Number of consecutive owned lanes strictly after lane.
+inline int RunAfter(std::uint64_t owned, int lane) {
+    std::uint64_t gaps = ~(owned >> (lane * 2 + 2)) & kLaneLowBits;
+    return CountTrailingZeros(gaps) / 2;
+}
+
+// Number of consecutive owned lanes strictly before lane. Requires lane >= 1.
+inline int RunBefore(std::uint64_t owned, int lane) {
+    std::uint64_t gaps = ~(owned << (64 - lane * 2)) & kLaneLowBits;
+    return (CountLeadingZeros(gaps) - 1) / 2;
+}
+
+} // namespace bitboard
+
+#endif
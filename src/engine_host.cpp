@@ -0,0 +1,574 @@
+#include "engine_host.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+#include <utility>
+
+#include "gomoku.h"
+#include "threat_solver.h"
+
+namespace {
+
+using HostClock = std::chrono::steady_clock;
+using Moves = std::vector<std::pair<int, int>>;
+
+constexpr long long kMaxSessionHashMb = 1024;
+
+bool ParseInt(const std::string &text, long long min_value, long long max_value, long long &value) {
+    char *end = nullptr;
+    long long parsed = std::strtoll(text.c_str(), &end, 10);
+    if (end == text.c_str() || *end != '\0' || parsed < min_value || parsed > max_value) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+bool ParseMove(const std::string &text, std::pair<int, int> &move) {
+    char trailing = 0;
+    return std::sscanf(text.c_str(), "%d,%d%c", &move.first, &move.second, &trailing) == 2;
+}
+
+bool ParseLevel(const std::string &text, AiDifficulty &difficulty) {
+    if (text == "easy") {
+        difficulty = AiDifficulty::Easy;
+    } else if (text == "normal") {
+        difficulty = AiDifficulty::Normal;
+    } else if (text == "hard") {
+        difficulty = AiDifficulty::Hard;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char *LevelName(AiDifficulty difficulty) {
+    switch (difficulty) {
+        case AiDifficulty::Easy:
+            return "easy";
+        case AiDifficulty::Normal:
+            return "normal";
+        default:
+            return "hard";
+    }
+}
+
+// What a session holds while it is open: itself, its table, its moves and,
+// at Hard, the threat solver the table keeps from the first search on.
+std::size_t SessionBytes(int board_size, AiDifficulty difficulty, std::size_t hash_mb) {
+    std::size_t cell_count = static_cast<std::size_t>(board_size * board_size);
+    std::size_t bytes = (hash_mb << 20) + cell_count * sizeof(Moves::value_type);
+    if (difficulty == AiDifficulty::Hard) {
+        bytes += ThreatSolver::memoryBytes(ThreatSolver::kDefaultTableBits);
+    }
+    return bytes;
+}
+
+// What a session's search uses while it is queued or running on top of
+// that: the game its moves are replayed into and, at Hard, the search's
+// worker state.
+std::size_t SearchBytes(int board_size, AiDifficulty difficulty) {
+    std::size_t bytes = WithBoardSize(board_size, [](auto size) {
+        using Game = BasicGomokuGame<decltype(size)::value>;
+        return sizeof(Game) + Game::kCellCount * sizeof(Move);
+    });
+    if (difficulty == AiDifficulty::Hard) {
+        bytes += SearchMemoryBytes(board_size, 1);
+    }
+    return bytes;
+}
+
+double MillisecondsSince(HostClock::time_point start) {
+    return std::chrono::duration<double, std::milli>(HostClock::now() - start).count();
+}
+
+// Plays moves on a fresh game, alternating from black. Returns false when a
+// move is illegal or comes after the game has ended; over is set when the
+// last move won or filled the board.
+template <int Size>
+bool Replay(const Moves &moves, BasicGomokuGame<Size> &game, bool &over) {
+    game.reset();
+    over = false;
+    int player = GomokuGame::kBlack;
+    for (const auto &move : moves) {
+        if (over || !game.placeStone(move.first, move.second, player)) {
+            return false;
+        }
+        over = game.checkWin(move.first, move.second, player) || game.isBoardFull();
+        player = player == GomokuGame::kBlack ? GomokuGame::kWhite : GomokuGame::kBlack;
+    }
+    game.setCurrentPlayer(player);
+    return true;
+}
+
+bool CheckMoves(int board_size, const Moves &moves, bool &over) {
+    return WithBoardSize(board_size, [&](auto size) {
+        BasicGomokuGame<decltype(size)::value> game;
+        return Replay(moves, game, over);
+    });
+}
+
+} // namespace
+
+struct EngineHost::Connection {
+    int id = 0;
+    Writer writer;
+    // Serializes writes; open is cleared on disconnect.
+    std::mutex mutex;
+    bool open = true;
+    // Searches asked for and not yet answered; guarded by the host's mutex.
+    int unanswered = 0;
+};
+
+struct EngineHost::Session {
+    int id = 0;
+    int connection = 0;
+    int board_size = GomokuGame::kBoardSize;
+    AiDifficulty difficulty = AiDifficulty::Hard;
+    int time_ms = 0;
+    TranspositionTable table;
+    CancellationToken cancel;
+    std::size_t memory_bytes = 0;
+    // Reserved from go until the search finishes.
+    std::size_t search_bytes = 0;
+    // The rest is guarded by the host's mutex.
+    Moves moves;
+    bool over = false;
+    bool searching = false;
+    bool closed = false;
+
+    explicit Session(std::size_t hash_mb) : table(hash_mb) {}
+};
+
+EngineHost::EngineHost(const HostOptions &options)
+    : options_(options), pool_(std::make_unique<WorkStealingPool>(options.workers, options.queue_capacity)) {}
+
+EngineHost::~EngineHost() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &entry : sessions_) {
+            closeLocked(*entry.second);
+        }
+        sessions_.clear();
+    }
+    // Queued searches find their sessions closed and return at once.
+    pool_.reset();
+}
+
+int EngineHost::connect(Writer writer) {
+    auto connection = std::make_shared<Connection>();
+    connection->writer = std::move(writer);
+    std::lock_guard<std::mutex> lock(mutex_);
+    connection->id = ++next_connection_;
+    connections_[connection->id] = connection;
+    return connection->id;
+}
+
+void EngineHost::disconnect(int id) {
+    std::shared_ptr<Connection> connection;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = connections_.find(id);
+        if (found == connections_.end()) {
+            return;
+        }
+        connection = found->second;
+        connections_.erase(found);
+        for (auto it = sessions_.begin(); it != sessions_.end();) {
+            if (it->second->connection == id) {
+                closeLocked(*it->second);
+                it = sessions_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    std::lock_guard<std::mutex> lock(connection->mutex);
+    connection->open = false;
+}
+
+bool EngineHost::handle(int id, const std::string &line) {
+    std::shared_ptr<Connection> connection;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = connections_.find(id);
+        if (found == connections_.end()) {
+            return false;
+        }
+        connection = found->second;
+    }
+    Tokens tokens;
+    std::istringstream stream(line);
+    for (std::string token; stream >> token;) {
+        tokens.push_back(token);
+    }
+    if (tokens.empty()) {
+        return true;
+    }
+    const std::string &command = tokens.front();
+    if (command == "quit") {
+        return false;
+    }
+    if (command == "new") {
+        openSession(*connection, tokens);
+        return true;
+    }
+    if (command == "stats") {
+        stats(*connection);
+        return true;
+    }
+    if (command != "position" && command != "play" && command != "go" && command != "stop" && command != "info"
+        && command != "close") {
+        send(*connection, "error unknown command '" + command + "'");
+        return true;
+    }
+
+    long long number = 0;
+    std::shared_ptr<Session> session;
+    if (tokens.size() >= 2 && ParseInt(tokens[1], 1, std::numeric_limits<int>::max(), number)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = sessions_.find(static_cast<int>(number));
+        if (found != sessions_.end() && found->second->connection == id) {
+            session = found->second;
+        }
+    }
+    if (!session) {
+        send(*connection, "error " + (tokens.size() >= 2 ? tokens[1] + " " : std::string()) + "unknown session");
+        return true;
+    }
+    if (command == "position") {
+        setPosition(*connection, *session, tokens);
+    } else if (command == "play") {
+        play(*connection, *session, tokens);
+    } else if (command == "go") {
+        go(connection, session);
+    } else if (command == "stop") {
+        stop(*connection, *session);
+    } else if (command == "info") {
+        info(*connection, *session);
+    } else {
+        closeSession(*connection, *session);
+    }
+    return true;
+}
+
+void EngineHost::wait(int id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto found = connections_.find(id);
+    if (found == connections_.end()) {
+        return;
+    }
+    std::shared_ptr<Connection> connection = found->second;
+    answered_.wait(lock, [&]() { return connection->unanswered == 0; });
+}
+
+void EngineHost::send(Connection &connection, const std::string &line) {
+    std::lock_guard<std::mutex> lock(connection.mutex);
+    if (connection.open) {
+        connection.writer(line);
+    }
+}
+
+void EngineHost::openSession(Connection &connection, const Tokens &tokens) {
+    int board_size = GomokuGame::kBoardSize;
+    AiDifficulty difficulty = AiDifficulty::Hard;
+    int time_ms = std::min(options_.time_ms, options_.max_time_ms);
+    std::size_t hash_mb = options_.session_hash_mb;
+    for (std::size_t i = 1; i < tokens.size(); i += 2) {
+        const std::string &name = tokens[i];
+        bool has_value = i + 1 < tokens.size();
+        long long number = 0;
+        if (name == "size" && has_value && ParseInt(tokens[i + 1], 0, 64, number)
+            && IsSupportedBoardSize(static_cast<int>(number))) {
+            board_size = static_cast<int>(number);
+        } else if (name == "time" && has_value && ParseInt(tokens[i + 1], 1, options_.max_time_ms, number)) {
+            time_ms = static_cast<int>(number);
+        } else if (name == "hash" && has_value && ParseInt(tokens[i + 1], 1, kMaxSessionHashMb, number)) {
+            hash_mb = static_cast<std::size_t>(number);
+        } else if (name != "level" || !has_value || !ParseLevel(tokens[i + 1], difficulty)) {
+            send(connection, "error bad option '" + name + "'");
+            return;
+        }
+    }
+    // Reserved before the table is allocated, in the same step as the check,
+    // so concurrent requests cannot take the host past the limit together.
+    // The session must also leave room for one search of its own.
+    const std::size_t memory = sizeof(Session) + SessionBytes(board_size, difficulty, hash_mb);
+    const std::size_t search_memory = SearchBytes(board_size, difficulty);
+    bool reserved = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reserved = memory_bytes_ + memory + search_memory <= options_.memory_mb << 20;
+        if (reserved) {
+            memory_bytes_ += memory;
+        }
+    }
+    if (!reserved) {
+        send(connection, "error memory limit reached");
+        return;
+    }
+    auto session = std::make_shared<Session>(hash_mb);
+    session->connection = connection.id;
+    session->board_size = board_size;
+    session->difficulty = difficulty;
+    session->time_ms = time_ms;
+    session->moves.reserve(static_cast<std::size_t>(board_size * board_size));
+    session->memory_bytes = memory;
+    session->search_bytes = search_memory;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        session->id = ++next_session_;
+        sessions_[session->id] = session;
+    }
+    send(connection, "session " + std::to_string(session->id));
+}
+
+void EngineHost::setPosition(Connection &connection, Session &session, const Tokens &tokens) {
+    const std::string id = std::to_string(session.id);
+    Moves moves;
+    moves.reserve(session.moves.capacity());
+    for (std::size_t i = 2; i < tokens.size(); ++i) {
+        std::pair<int, int> move;
+        if (!ParseMove(tokens[i], move)) {
+            send(connection, "error " + id + " bad move '" + tokens[i] + "'");
+            return;
+        }
+        moves.push_back(move);
+    }
+    bool over = false;
+    if (!CheckMoves(session.board_size, moves, over)) {
+        send(connection, "error " + id + " illegal position");
+        return;
+    }
+    bool searching = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        searching = session.searching;
+        if (!searching) {
+            session.moves.swap(moves);
+            session.over = over;
+        }
+    }
+    send(connection, searching ? "error " + id + " searching" : "ok " + id);
+}
+
+void EngineHost::play(Connection &connection, Session &session, const Tokens &tokens) {
+    const std::string id = std::to_string(session.id);
+    std::pair<int, int> move;
+    if (tokens.size() != 3 || !ParseMove(tokens[2], move)) {
+        send(connection, "error " + id + " bad move");
+        return;
+    }
+    std::string error;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bool over = false;
+        if (session.searching) {
+            error = "searching";
+        } else if (session.over) {
+            error = "game over";
+        } else {
+            session.moves.push_back(move);
+            if (CheckMoves(session.board_size, session.moves, over)) {
+                session.over = over;
+            } else {
+                session.moves.pop_back();
+                error = "illegal move '" + tokens[2] + "'";
+            }
+        }
+    }
+    send(connection, error.empty() ? "ok " + id : "error " + id + " " + error);
+}
+
+void EngineHost::go(const std::shared_ptr<Connection> &connection, const std::shared_ptr<Session> &session) {
+    const std::string id = std::to_string(session->id);
+    const HostClock::time_point asked = HostClock::now();
+    std::string error;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (session->searching) {
+            error = "searching";
+        } else if (session->over) {
+            error = "game over";
+        } else if (memory_bytes_ + session->search_bytes > options_.memory_mb << 20) {
+            error = "memory limit reached";
+        } else {
+            session->searching = true;
+            session->cancel.reset();
+            memory_bytes_ += session->search_bytes;
+            ++connection->unanswered;
+        }
+    }
+    if (!error.empty()) {
+        send(*connection, "error " + id + " " + error);
+        return;
+    }
+    if (!pool_->submit([this, connection, session, asked]() { search(*connection, *session, asked); })) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            session->searching = false;
+            memory_bytes_ -= session->search_bytes;
+            --connection->unanswered;
+        }
+        send(*connection, "busy " + id);
+    }
+}
+
+void EngineHost::search(Connection &connection, Session &session, HostClock::time_point asked) {
+    Moves moves;
+    bool closed = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed = session.closed;
+        moves = session.moves;
+        if (closed) {
+            memory_bytes_ -= session.search_bytes;
+        }
+    }
+    if (closed) {
+        answer(connection);
+        return;
+    }
+    AiSearchOptions options;
+    options.tt = &session.table;
+    options.cancel = &session.cancel;
+    options.time_budget_ms = std::max(1, session.time_ms - static_cast<int>(MillisecondsSince(asked)));
+    bool over = false;
+    AiSearchResult result = WithBoardSize(session.board_size, [&](auto size) {
+        BasicGomokuGame<decltype(size)::value> game;
+        Replay(moves, game, over);
+        int ai_player = game.currentPlayer();
+        int human_player = ai_player == GomokuGame::kBlack ? GomokuGame::kWhite : GomokuGame::kBlack;
+        AiSearchResult found = SearchAiMove(game, ai_player, human_player, session.difficulty, options);
+        game.placeStone(found.move.first, found.move.second, ai_player);
+        over = game.checkWin(found.move.first, found.move.second, ai_player) || game.isBoardFull();
+        return found;
+    });
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        session.searching = false;
+        memory_bytes_ -= session.search_bytes;
+        closed = session.closed;
+        if (!closed) {
+            session.moves.push_back(result.move);
+            session.over = over;
+        }
+    }
+    if (closed) {
+        answer(connection);
+        return;
+    }
+    double latency_ms = MillisecondsSince(asked);
+    recordLatency(latency_ms);
+    char line[192];
+    std::snprintf(line, sizeof(line), "move %d %d,%d score %d depth %d nodes %llu time_ms %.2f latency_ms %.2f",
+                  session.id, result.move.first, result.move.second, result.score, result.depth,
+                  static_cast<unsigned long long>(result.nodes), result.elapsed_ms, latency_ms);
+    send(connection, line);
+    answer(connection);
+}
+
+// Called once a search's reply has been sent, or dropped with its session.
+void EngineHost::answer(Connection &connection) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --connection.unanswered;
+    }
+    answered_.notify_all();
+}
+
+void EngineHost::stop(Connection &connection, Session &session) {
+    session.cancel.cancel();
+    send(connection, "ok " + std::to_string(session.id));
+}
+
+void EngineHost::info(Connection &connection, const Session &session) {
+    std::size_t moves = 0;
+    bool searching = false;
+    std::size_t memory = session.memory_bytes;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        moves = session.moves.size();
+        searching = session.searching;
+        if (searching) {
+            memory += session.search_bytes;
+        }
+    }
+    char line[192];
+    std::snprintf(line, sizeof(line), "session %d size %d level %s time_ms %d moves %zu memory_kb %zu searching %d",
+                  session.id, session.board_size, LevelName(session.difficulty), session.time_ms, moves,
+                  memory >> 10, searching ? 1 : 0);
+    send(connection, line);
+}
+
+void EngineHost::closeSession(Connection &connection, Session &session) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closeLocked(session);
+        sessions_.erase(session.id);
+    }
+    send(connection, "ok " + std::to_string(session.id));
+}
+
+void EngineHost::closeLocked(Session &session) {
+    if (session.closed) {
+        return;
+    }
+    session.closed = true;
+    session.cancel.cancel();
+    memory_bytes_ -= session.memory_bytes;
+}
+
+void EngineHost::stats(Connection &connection) {
+    LatencySummary summary = latency();
+    char line[256];
+    std::snprintf(line, sizeof(line),
+                  "stats sessions %zu memory_kb %zu workers %d queued %zu requests %llu p50_ms %.2f p99_ms %.2f",
+                  sessionCount(), memoryBytes() >> 10, pool_->threadCount(), pool_->queued(),
+                  static_cast<unsigned long long>(summary.requests), summary.p50_ms, summary.p99_ms);
+    send(connection, line);
+}
+
+std::size_t EngineHost::sessionCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sessions_.size();
+}
+
+std::size_t EngineHost::memoryBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memory_bytes_;
+}
+
+void EngineHost::recordLatency(double ms) {
+    std::lock_guard<std::mutex> lock(latency_mutex_);
+    latencies_[requests_ % kLatencyWindow] = ms;
+    ++requests_;
+}
+
+LatencySummary EngineHost::latency() const {
+    std::array<double, kLatencyWindow> window;
+    LatencySummary summary;
+    {
+        std::lock_guard<std::mutex> lock(latency_mutex_);
+        summary.requests = requests_;
+        window = latencies_;
+    }
+    std::size_t count = static_cast<std::size_t>(std::min<std::uint64_t>(summary.requests, kLatencyWindow));
+    if (count == 0) {
+        return summary;
+    }
+    std::sort(window.begin(), window.begin() + count);
+    // Nearest rank: the smallest sample at or above the given share.
+    auto percentile = [&](double share) {
+        std::size_t rank = static_cast<std::size_t>(std::ceil(share * count));
+        return window[std::max<std::size_t>(rank, 1) - 1];
+    };
+    summary.p50_ms = percentile(0.50);
+    summary.p99_ms = percentile(0.99);
+    summary.max_ms = window[count - 1];
+    return summary;
+}
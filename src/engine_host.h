@@ -0,0 +1,136 @@
+#ifndef GOMOKU_ENGINE_HOST_H
+#define GOMOKU_ENGINE_HOST_H
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "gomoku_ai.h"
+#include "work_pool.h"
+
+struct HostOptions {
+    // Search threads shared by every session; 0 uses every hardware thread.
+    int workers = 0;
+    // Searches waiting for a worker before go answers busy.
+    std::size_t queue_capacity = 256;
+    // Limit on the memory of all sessions together.
+    std::size_t memory_mb = 1024;
+    // Defaults for new sessions.
+    std::size_t session_hash_mb = 1;
+    int time_ms = 1000;
+    // Upper bound on a session's time per move.
+    int max_time_ms = 60000;
+};
+
+// Request latency, from the go line arriving to the move being sent, over
+// the most recent requests.
+struct LatencySummary {
+    std::uint64_t requests = 0;
+    double p50_ms = 0.0;
+    double p99_ms = 0.0;
+    double max_ms = 0.0;
+};
+
+// Plays many games at once on one pool of search threads. Clients connect,
+// open sessions (one game each) and talk to them over a line protocol:
+//
+//   new [size 15|19|20] [level easy|normal|hard] [time MS] [hash MB]
+//                             -> session ID
+//   position ID [x,y ...]     -> ok ID          replace the moves so far
+//   play ID x,y               -> ok ID          the opponent's move
+//   go ID                     -> move ID x,y score S depth D nodes N time_ms T latency_ms L
+//                                               or busy ID when the queue is full
+//   stop ID                   -> ok ID          finish the search early
+//   info ID                   -> session ID size S level L time_ms T moves K memory_kb M searching 0|1
+//   close ID                  -> ok ID
+//   stats                     -> stats sessions N memory_kb M workers W queued Q requests R p50_ms A p99_ms B
+//   quit                      ends the connection
+//
+// Moves are 0-based, black first, and the engine plays for the side to
+// move; its move is added to the game. Failures answer "error [ID] reason".
+// The move line arrives later, from a search thread, and other replies may
+// come before it.
+//
+// Scheduling: a session has at most one search queued or running, so no
+// session can crowd out the others, and searches start in the order they
+// were asked for, stealing between threads to keep them all busy. A session's
+// time per move counts from its go line, so time spent queued shortens the
+// search rather than delaying the reply. Each session owns its own
+// transposition table; its memory, with the moves and what the session's
+// search uses while it runs, counts against the host's limit. new fails
+// beyond it, and go fails while the searches running leave no room; the
+// search's share is reserved at go and released when it finishes.
+class EngineHost {
+public:
+    // Sends one reply line, without the newline. Called from the thread
+    // handling the connection's line and from search threads, one call at a
+    // time per connection.
+    using Writer = std::function<void(const std::string &line)>;
+
+    explicit EngineHost(const HostOptions &options);
+    // Stops every search and waits for the threads.
+    ~EngineHost();
+
+    EngineHost(const EngineHost &) = delete;
+    EngineHost &operator=(const EngineHost &) = delete;
+
+    int connect(Writer writer);
+    // Handles one protocol line; returns false on quit.
+    bool handle(int connection, const std::string &line);
+    // Blocks until every search the connection asked for has answered.
+    void wait(int connection);
+    // Closes the connection's sessions. Its writer is not called once this
+    // returns.
+    void disconnect(int connection);
+
+    std::size_t sessionCount() const;
+    std::size_t memoryBytes() const;
+    LatencySummary latency() const;
+
+private:
+    struct Connection;
+    struct Session;
+    using Tokens = std::vector<std::string>;
+
+    void send(Connection &connection, const std::string &line);
+    void openSession(Connection &connection, const Tokens &tokens);
+    void setPosition(Connection &connection, Session &session, const Tokens &tokens);
+    void play(Connection &connection, Session &session, const Tokens &tokens);
+    void go(const std::shared_ptr<Connection> &connection, const std::shared_ptr<Session> &session);
+    void search(Connection &connection, Session &session, std::chrono::steady_clock::time_point asked);
+    void answer(Connection &connection);
+    void stop(Connection &connection, Session &session);
+    void info(Connection &connection, const Session &session);
+    void closeSession(Connection &connection, Session &session);
+    void stats(Connection &connection);
+    void closeLocked(Session &session);
+    void recordLatency(double ms);
+
+    HostOptions options_;
+    // Guards sessions, connections and the session state they share with
+    // search threads.
+    mutable std::mutex mutex_;
+    std::condition_variable answered_;
+    std::map<int, std::shared_ptr<Connection>> connections_;
+    std::map<int, std::shared_ptr<Session>> sessions_;
+    int next_connection_ = 0;
+    int next_session_ = 0;
+    std::size_t memory_bytes_ = 0;
+
+    static constexpr std::size_t kLatencyWindow = 4096;
+    mutable std::mutex latency_mutex_;
+    std::array<double, kLatencyWindow> latencies_{};
+    std::uint64_t requests_ = 0;
+
+    std::unique_ptr<WorkStealingPool> pool_;
+};
+
+#endif
@@ -0,0 +1,339 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "batch_eval.h"
+#include "gomoku.h"
+#include "gomoku_ai.h"
+#include "opening_book.h"
+#include "position_cache.h"
+
+// Headless engine front end. Each position is a move list of x,y pairs
+// (0-based, black first, alternating) on one line; the engine searches for
+// the side to move and prints one result line per position.
+namespace {
+
+struct EngineOptions {
+    AiDifficulty difficulty = AiDifficulty::Hard;
+    AiSearchOptions search;
+    std::size_t hash_mb = TranspositionTable::kDefaultMegabytes;
+    std::size_t cache_mb = PositionCache::kDefaultMegabytes;
+    int board_size = GomokuGame::kBoardSize;
+    bool keep_table = false;
+    bool print_stats = false;
+    bool static_eval = false;
+    std::string book_path;
+    std::string make_book_path;
+    std::string cache_path;
+    std::string position;
+    std::string input_path;
+};
+
+void PrintUsage(const char *program) {
+    std::fprintf(stderr,
+                 "usage: %s [options] [positions-file]\n"
+                 "  --difficulty easy|normal|hard   AI level (default hard)\n"
+                 "  --board-size 15|19|20           board size (default 15)\n"
+                 "  --time-ms N                     Hard time budget per move\n"
+                 "  --nodes N                       Hard node budget per move\n"
+                 "  --depth N                       Hard maximum depth\n"
+                 "  --threads N                     Hard search or --static threads\n"
+                 "  --hash-mb N                     transposition table size\n"
+                 "  --keep-table                    keep the table between positions\n"
+                 "  --stats                         print search statistics per position\n"
+                 "  --book FILE                     play Hard moves from an opening book\n"
+                 "  --make-book FILE                write the moves found to a book file\n"
+                 "  --cache FILE                    keep Hard results in a file across runs\n"
+                 "  --cache-mb N                    size of a newly created cache file\n"
+                 "  --position \"x,y x,y ...\"        search a single position\n"
+                 "  --static                        evaluate statically, in one batch, instead of searching\n"
+                 "Positions are read one per line from the file, or from stdin.\n",
+                 program);
+}
+
+bool ParseNumber(const char *text, long long min_value, long long &value) {
+    char *end = nullptr;
+    long long parsed = std::strtoll(text, &end, 10);
+    if (end == text || *end != '\0' || parsed < min_value) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+bool ParseDifficulty(const std::string &text, AiDifficulty &difficulty) {
+    if (text == "easy") {
+        difficulty = AiDifficulty::Easy;
+    } else if (text == "normal") {
+        difficulty = AiDifficulty::Normal;
+    } else if (text == "hard") {
+        difficulty = AiDifficulty::Hard;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool ParseArguments(int argc, char **argv, EngineOptions &options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        long long number = 0;
+        if (arg == "--keep-table") {
+            options.keep_table = true;
+        } else if (arg == "--stats") {
+            options.print_stats = true;
+        } else if (arg == "--static") {
+            options.static_eval = true;
+        } else if (arg == "--difficulty" && has_value) {
+            if (!ParseDifficulty(argv[++i], options.difficulty)) {
+                return false;
+            }
+        } else if (arg == "--book" && has_value) {
+            options.book_path = argv[++i];
+        } else if (arg == "--make-book" && has_value) {
+            options.make_book_path = argv[++i];
+        } else if (arg == "--cache" && has_value) {
+            options.cache_path = argv[++i];
+        } else if (arg == "--position" && has_value) {
+            options.position = argv[++i];
+        } else if (arg == "--time-ms" && has_value && ParseNumber(argv[++i], 0, number)) {
+            options.search.time_budget_ms = static_cast<int>(number);
+        } else if (arg == "--nodes" && has_value && ParseNumber(argv[++i], 0, number)) {
+            options.search.node_budget = static_cast<std::uint64_t>(number);
+        } else if (arg == "--depth" && has_value && ParseNumber(argv[++i], 0, number)) {
+            options.search.max_depth = static_cast<int>(number);
+        } else if (arg == "--threads" && has_value && ParseNumber(argv[++i], 1, number)) {
+            options.search.threads = static_cast<int>(number);
+        } else if (arg == "--hash-mb" && has_value && ParseNumber(argv[++i], 1, number)) {
+            options.hash_mb = static_cast<std::size_t>(number);
+        } else if (arg == "--cache-mb" && has_value && ParseNumber(argv[++i], 1, number)) {
+            options.cache_mb = static_cast<std::size_t>(number);
+        } else if (arg == "--board-size" && has_value && ParseNumber(argv[++i], 0, number)
+                   && IsSupportedBoardSize(static_cast<int>(number))) {
+            options.board_size = static_cast<int>(number);
+        } else if (!arg.empty() && arg[0] != '-' && options.input_path.empty()) {
+            options.input_path = arg;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Replays a move list onto game. Returns false with a message on malformed
+// or illegal input.
+template <int Size>
+bool LoadPosition(const std::string &text, BasicGomokuGame<Size> &game, std::string &error) {
+    game.reset();
+    std::istringstream stream(text);
+    std::string token;
+    int player = GomokuGame::kBlack;
+    while (stream >> token) {
+        int x = 0;
+        int y = 0;
+        char trailing = 0;
+        if (std::sscanf(token.c_str(), "%d,%d%c", &x, &y, &trailing) != 2) {
+            error = "bad move '" + token + "'";
+            return false;
+        }
+        if (!game.placeStone(x, y, player)) {
+            error = "illegal move '" + token + "'";
+            return false;
+        }
+        if (game.checkWin(x, y, player)) {
+            error = "game already won at '" + token + "'";
+            return false;
+        }
+        player = player == GomokuGame::kBlack ? GomokuGame::kWhite : GomokuGame::kBlack;
+    }
+    game.setCurrentPlayer(player);
+    if (game.isBoardFull()) {
+        error = "board is full";
+        return false;
+    }
+    return true;
+}
+
+void PrintStats(int index, const SearchStats &stats) {
+    std::printf("position %d stats leaves %llu interior %llu solver_nodes %llu cutoffs %llu first_cutoff %.3f "
+                "ebf %.2f candidates avg %.1f max %d researches %llu aspiration_failures %llu reductions %llu "
+                "reduction_researches %llu\n",
+                index, static_cast<unsigned long long>(stats.leaves),
+                static_cast<unsigned long long>(stats.interior_nodes),
+                static_cast<unsigned long long>(stats.solver_nodes), static_cast<unsigned long long>(stats.cutoffs),
+                stats.firstMoveCutoffRate(), stats.effectiveBranchingFactor(), stats.averageCandidates(),
+                stats.max_candidates, static_cast<unsigned long long>(stats.pvs_researches),
+                static_cast<unsigned long long>(stats.aspiration_failures),
+                static_cast<unsigned long long>(stats.reductions),
+                static_cast<unsigned long long>(stats.reduction_researches));
+    for (const SearchIterationStats &iteration : stats.iterations) {
+        std::printf("position %d iteration depth %d time_ms %.2f nodes %llu\n", index, iteration.depth,
+                    iteration.elapsed_ms, static_cast<unsigned long long>(iteration.nodes));
+    }
+}
+
+// Blank lines and lines starting with '#' are skipped.
+bool IsBlank(const std::string &line) {
+    std::size_t first = line.find_first_not_of(" \t\r");
+    return first == std::string::npos || line[first] == '#';
+}
+
+// Shared state of one engine run: the table, the persistent cache, the book
+// being played from, and the book being written.
+struct EngineSession {
+    TranspositionTable table;
+    PositionCache cache;
+    OpeningBook book;
+    OpeningBookWriter book_writer;
+
+    explicit EngineSession(std::size_t hash_mb) : table(hash_mb) {}
+};
+
+template <int Size>
+void RunPosition(const EngineOptions &options, EngineSession &session, const std::string &text, int index) {
+    BasicGomokuGame<Size> game;
+    std::string error;
+    if (!LoadPosition(text, game, error)) {
+        std::printf("position %d error %s\n", index, error.c_str());
+        return;
+    }
+    if (!options.keep_table) {
+        session.table.clear();
+    }
+    int ai_player = game.currentPlayer();
+    int human_player = ai_player == GomokuGame::kBlack ? GomokuGame::kWhite : GomokuGame::kBlack;
+    SearchStats stats;
+    AiSearchOptions search = options.search;
+    search.tt = &session.table;
+    search.stats = options.print_stats ? &stats : nullptr;
+    search.book = session.book.isOpen() ? &session.book : nullptr;
+    search.cache = session.cache.isOpen() ? &session.cache : nullptr;
+    AiSearchResult result = SearchAiMove(game, ai_player, human_player, options.difficulty, search);
+    std::printf("position %d move %d,%d score %d depth %d nodes %llu time_ms %.2f%s\n", index, result.move.first,
+                result.move.second, result.score, result.depth, static_cast<unsigned long long>(result.nodes),
+                result.elapsed_ms, result.from_book ? " book" : "");
+    if constexpr (Size == GomokuGame::kBoardSize) {
+        if (!options.make_book_path.empty()) {
+            session.book_writer.add(game, result.move);
+        }
+    }
+    if (options.print_stats) {
+        PrintStats(index, stats);
+    }
+    std::fflush(stdout);
+}
+
+int SaveBook(const EngineOptions &options, const EngineSession &session) {
+    if (options.make_book_path.empty()) {
+        return 0;
+    }
+    if (!session.book_writer.save(options.make_book_path)) {
+        std::fprintf(stderr, "cannot write book %s\n", options.make_book_path.c_str());
+        return 1;
+    }
+    return 0;
+}
+
+// Loads every position first, then scores the valid ones in one batch and
+// prints the results in input order.
+template <int Size>
+void RunStatic(const EngineOptions &options, const std::vector<std::string> &lines) {
+    std::vector<BasicPackedPosition<Size>> positions;
+    std::vector<std::string> errors(lines.size());
+    BasicGomokuGame<Size> game;
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+        if (LoadPosition(lines[i], game, errors[i])) {
+            positions.push_back(BasicPackedPosition<Size>::pack(game));
+        }
+    }
+    std::vector<PositionEval> results(positions.size());
+    BasicBatchEvaluator<Size> evaluator(options.search.threads);
+    evaluator.evaluate(positions.data(), positions.size(), results.data());
+    std::size_t next = 0;
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+        if (!errors[i].empty()) {
+            std::printf("position %zu error %s\n", i + 1, errors[i].c_str());
+            continue;
+        }
+        const PositionEval &result = results[next++];
+        std::printf("position %zu move %d,%d eval %d\n", i + 1, result.move.first, result.move.second, result.score);
+    }
+}
+
+template <int Size>
+int RunPositions(const EngineOptions &options, EngineSession &session) {
+    if (!options.position.empty()) {
+        if (options.static_eval) {
+            RunStatic<Size>(options, {options.position});
+            return 0;
+        }
+        RunPosition<Size>(options, session, options.position, 1);
+        return SaveBook(options, session);
+    }
+
+    std::ifstream file;
+    std::istream *in = &std::cin;
+    if (!options.input_path.empty()) {
+        file.open(options.input_path);
+        if (!file) {
+            std::fprintf(stderr, "cannot open %s\n", options.input_path.c_str());
+            return 1;
+        }
+        in = &file;
+    }
+
+    std::string line;
+    int index = 0;
+    std::vector<std::string> batch;
+    while (std::getline(*in, line)) {
+        if (IsBlank(line)) {
+            continue;
+        }
+        if (options.static_eval) {
+            batch.push_back(line);
+        } else {
+            RunPosition<Size>(options, session, line, ++index);
+        }
+    }
+    if (options.static_eval) {
+        RunStatic<Size>(options, batch);
+        return 0;
+    }
+    return SaveBook(options, session);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    EngineOptions options;
+    if (!ParseArguments(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+    if (options.board_size != GomokuGame::kBoardSize
+        && (!options.book_path.empty() || !options.make_book_path.empty())) {
+        std::fprintf(stderr, "opening books are only supported on the %dx%d board\n", GomokuGame::kBoardSize,
+                     GomokuGame::kBoardSize);
+        return 2;
+    }
+
+    EngineSession session(options.hash_mb);
+    if (!options.book_path.empty() && !session.book.open(options.book_path)) {
+        std::fprintf(stderr, "cannot open book %s\n", options.book_path.c_str());
+        return 1;
+    }
+    // An unusable cache only costs speed, so the run goes on without it.
+    if (!options.cache_path.empty()
+        && !session.cache.open(options.cache_path, options.cache_mb, options.board_size)) {
+        std::fprintf(stderr, "ignoring cache %s: cannot open it, or it was not written by this engine\n",
+                     options.cache_path.c_str());
+    }
+    return WithBoardSize(options.board_size, [&](auto size) {
+        return RunPositions<decltype(size)::value>(options, session);
+    });
+}
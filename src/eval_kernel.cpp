@@ -0,0 +1,280 @@
+#include "eval_kernel.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#include "gomoku_eval.h"
+#include "line_patterns.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define GOMOKU_AVX2_KERNEL 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC compiles intrinsics for any target; GCC and Clang need the
+// functions that use them marked.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define GOMOKU_TARGET_AVX2
+#else
+#define GOMOKU_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace {
+
+bool CpuHasAvx2() {
+#if !defined(GOMOKU_AVX2_KERNEL)
+    return false;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int info[4] = {};
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool os_saves_avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return os_saves_avx && (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+std::atomic<EvalKernel> &KernelSlot() {
+    static std::atomic<EvalKernel> kernel{CpuHasAvx2() ? EvalKernel::Avx2 : EvalKernel::Scalar};
+    return kernel;
+}
+
+template <int Size>
+void EvaluateCellsScalar(const BasicGomokuGame<Size> &game, const int *cells, int count, int player, int *scores) {
+    for (int i = 0; i < count; ++i) {
+        scores[i] = EvaluateCell(game, cells[i] % Size, cells[i] / Size, player);
+    }
+}
+
+template <int Size>
+void ClassifyCellsScalar(const BasicGomokuGame<Size> &game, const int *cells, int count, CellThreats *threats) {
+    using Game = BasicGomokuGame<Size>;
+    for (int i = 0; i < count; ++i) {
+        int x = cells[i] % Size;
+        int y = cells[i] / Size;
+        for (int dir = 0; dir < 4; ++dir) {
+            std::uint64_t word = game.lineWord(dir, x, y);
+            int lane = Game::lineLane(dir, x, y);
+            threats[i].black[dir] = patterns::PatternAt(word, lane, GomokuGame::kBlack).threat;
+            threats[i].white[dir] = patterns::PatternAt(word, lane, GomokuGame::kWhite).threat;
+        }
+    }
+}
+
+#if defined(GOMOKU_AVX2_KERNEL)
+
+// Pattern of every 16-bit window, the four lanes on each side of the
+// centre with the centre removed, for player 1 then player 2: the level in
+// the low four bits and the threat class above. One gather then replaces
+// the two side-code lookups and the pattern lookup.
+constexpr int kWindowBits = patterns::kSideLanes * 4;
+constexpr int kWindowCount = 1 << kWindowBits;
+constexpr int kThreatShift = 4;
+// Gathers read four bytes at a time.
+constexpr int kPatternPadding = 3;
+
+constexpr std::array<std::uint8_t, kWindowCount * 2 + kPatternPadding> BuildWindowPatterns() {
+    std::array<std::uint8_t, kWindowCount * 2 + kPatternPadding> table{};
+    for (int player = 1; player <= 2; ++player) {
+        const auto &codes = patterns::kSideCodeTable[player - 1];
+        for (int window = 0; window < kWindowCount; ++window) {
+            int left = codes[window & 0xFF];
+            int right = codes[window >> 8];
+            patterns::LinePattern pattern = patterns::kPatternTable[left + right * patterns::kSideCodes];
+            table[(player - 1) * kWindowCount + window] =
+                static_cast<std::uint8_t>(pattern.level | static_cast<int>(pattern.threat) << kThreatShift);
+        }
+    }
+    return table;
+}
+
+constexpr auto kWindowPatterns = BuildWindowPatterns();
+
+// patterns::PatternAt for eight windows at once, as table bytes. words_lo
+// holds the line words of items 0-3 and words_hi of items 4-7, lanes the
+// centre lane of each, and sides 0 or kWindowCount by player.
+GOMOKU_TARGET_AVX2 __m256i WindowPatterns(__m256i words_lo, __m256i words_hi, __m256i lanes, __m256i sides) {
+    const __m256i window_mask = _mm256_set1_epi64x((1 << (kWindowBits + 2)) - 1);
+    __m256i shifts = _mm256_slli_epi32(_mm256_sub_epi32(lanes, _mm256_set1_epi32(patterns::kSideLanes)), 1);
+    __m256i lo = _mm256_and_si256(
+        _mm256_srlv_epi64(words_lo, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(shifts))), window_mask);
+    __m256i hi = _mm256_and_si256(
+        _mm256_srlv_epi64(words_hi, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(shifts, 1))), window_mask);
+    __m256i spans = _mm256_permutevar8x32_epi32(_mm256_or_si256(lo, _mm256_slli_epi64(hi, 32)),
+                                                _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7));
+    // Drop the centre lane: bits 8-9 of the 18-bit span.
+    __m256i windows = _mm256_or_si256(_mm256_and_si256(spans, _mm256_set1_epi32(0xFF)),
+                                      _mm256_slli_epi32(_mm256_srli_epi32(spans, 10), 8));
+    return _mm256_and_si256(_mm256_i32gather_epi32(reinterpret_cast<const int *>(kWindowPatterns.data()),
+                                                   _mm256_add_epi32(windows, sides), 1),
+                            _mm256_set1_epi32(0xFF));
+}
+
+// The level score of eight table bytes.
+GOMOKU_TARGET_AVX2 __m256i PatternScores(__m256i window_patterns) {
+    __m256i levels = _mm256_and_si256(window_patterns, _mm256_set1_epi32((1 << kThreatShift) - 1));
+    // Levels 0-7 come from a register; only a five scores above them.
+    const __m256i low_scores = _mm256_setr_epi32(patterns::kLevelScores[0], patterns::kLevelScores[1],
+                                                 patterns::kLevelScores[2], patterns::kLevelScores[3],
+                                                 patterns::kLevelScores[4], patterns::kLevelScores[5],
+                                                 patterns::kLevelScores[6], patterns::kLevelScores[7]);
+    __m256i scores = _mm256_permutevar8x32_epi32(low_scores, levels);
+    __m256i fives = _mm256_cmpeq_epi32(levels, _mm256_set1_epi32(8));
+    return _mm256_blendv_epi8(scores, _mm256_set1_epi32(patterns::kLevelScores[8]), fives);
+}
+
+// The four line words through a cell and the cell's lane in each.
+template <int Size>
+GOMOKU_TARGET_AVX2 __m256i CellWords(const BasicGomokuGame<Size> &game, int x, int y) {
+    using Game = BasicGomokuGame<Size>;
+    __m128i lines = _mm_setr_epi32(Game::lineIndex(0, x, y), Game::lineIndex(1, x, y), Game::lineIndex(2, x, y),
+                                   Game::lineIndex(3, x, y));
+    return _mm256_i32gather_epi64(reinterpret_cast<const long long *>(game.lineWords()), lines, 8);
+}
+
+template <int Size>
+GOMOKU_TARGET_AVX2 __m128i CellLanes(int x, int y) {
+    using Game = BasicGomokuGame<Size>;
+    return _mm_setr_epi32(Game::lineLane(0, x, y), Game::lineLane(1, x, y), Game::lineLane(2, x, y),
+                          Game::lineLane(3, x, y));
+}
+
+GOMOKU_TARGET_AVX2 __m256i Combine(__m128i lo, __m128i hi) {
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+// Two cells per step for one player; an odd last cell is scored twice.
+template <int Size>
+GOMOKU_TARGET_AVX2 void EvaluateCellsAvx2(const BasicGomokuGame<Size> &game, const int *cells, int count,
+                                          int player, int *scores) {
+    const __m256i sides = _mm256_set1_epi32((player - 1) * kWindowCount);
+    for (int i = 0; i < count; i += 2) {
+        const bool pair = i + 1 < count;
+        int x0 = cells[i] % Size;
+        int y0 = cells[i] / Size;
+        int x1 = pair ? cells[i + 1] % Size : x0;
+        int y1 = pair ? cells[i + 1] / Size : y0;
+        __m256i windows = PatternScores(WindowPatterns(CellWords(game, x0, y0), CellWords(game, x1, y1),
+                                                       Combine(CellLanes<Size>(x0, y0), CellLanes<Size>(x1, y1)),
+                                                       sides));
+        __m256i sums = _mm256_hadd_epi32(windows, windows);
+        sums = _mm256_hadd_epi32(sums, sums);
+        scores[i] = _mm256_extract_epi32(sums, 0);
+        if (pair) {
+            scores[i + 1] = _mm256_extract_epi32(sums, 4);
+        }
+    }
+}
+
+// One cell per step, black in the low four items and white in the high.
+template <int Size>
+GOMOKU_TARGET_AVX2 void EvaluateCellsBothAvx2(const BasicGomokuGame<Size> &game, const int *cells, int count,
+                                              int *black_scores, int *white_scores) {
+    const __m256i sides = _mm256_setr_epi32(0, 0, 0, 0, kWindowCount, kWindowCount, kWindowCount, kWindowCount);
+    for (int i = 0; i < count; ++i) {
+        int x = cells[i] % Size;
+        int y = cells[i] / Size;
+        __m256i words = CellWords(game, x, y);
+        __m128i lanes = CellLanes<Size>(x, y);
+        __m256i windows = PatternScores(WindowPatterns(words, words, Combine(lanes, lanes), sides));
+        __m256i sums = _mm256_hadd_epi32(windows, windows);
+        sums = _mm256_hadd_epi32(sums, sums);
+        black_scores[i] = _mm256_extract_epi32(sums, 0);
+        white_scores[i] = _mm256_extract_epi32(sums, 4);
+    }
+}
+
+// The same windows as EvaluateCellsBothAvx2, keeping the threat classes.
+template <int Size>
+GOMOKU_TARGET_AVX2 void ClassifyCellsAvx2(const BasicGomokuGame<Size> &game, const int *cells, int count,
+                                          CellThreats *threats) {
+    const __m256i sides = _mm256_setr_epi32(0, 0, 0, 0, kWindowCount, kWindowCount, kWindowCount, kWindowCount);
+    // Byte 0 of each item to bytes 0-3 of each half.
+    const __m256i pack = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 4, 8, 12,
+                                          -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    for (int i = 0; i < count; ++i) {
+        int x = cells[i] % Size;
+        int y = cells[i] / Size;
+        __m256i words = CellWords(game, x, y);
+        __m128i lanes = CellLanes<Size>(x, y);
+        __m256i classes = _mm256_shuffle_epi8(
+            _mm256_srli_epi32(WindowPatterns(words, words, Combine(lanes, lanes), sides), kThreatShift), pack);
+        std::uint32_t black = static_cast<std::uint32_t>(_mm256_extract_epi32(classes, 0));
+        std::uint32_t white = static_cast<std::uint32_t>(_mm256_extract_epi32(classes, 4));
+        std::memcpy(threats[i].black.data(), &black, sizeof(black));
+        std::memcpy(threats[i].white.data(), &white, sizeof(white));
+    }
+}
+
+#endif
+
+} // namespace
+
+EvalKernel ActiveEvalKernel() {
+    return KernelSlot().load(std::memory_order_relaxed);
+}
+
+bool SetEvalKernel(EvalKernel kernel) {
+    if (kernel == EvalKernel::Avx2 && !CpuHasAvx2()) {
+        return false;
+    }
+    KernelSlot().store(kernel, std::memory_order_relaxed);
+    return true;
+}
+
+const char *EvalKernelName(EvalKernel kernel) {
+    return kernel == EvalKernel::Avx2 ? "avx2" : "scalar";
+}
+
+template <int Size>
+void EvaluateCells(const BasicGomokuGame<Size> &game, const int *cells, int count, int player, int *scores) {
+#if defined(GOMOKU_AVX2_KERNEL)
+    if (ActiveEvalKernel() == EvalKernel::Avx2) {
+        EvaluateCellsAvx2(game, cells, count, player, scores);
+        return;
+    }
+#endif
+    EvaluateCellsScalar(game, cells, count, player, scores);
+}
+
+template <int Size>
+void EvaluateCellsBoth(const BasicGomokuGame<Size> &game, const int *cells, int count, int *black_scores,
+                       int *white_scores) {
+#if defined(GOMOKU_AVX2_KERNEL)
+    if (ActiveEvalKernel() == EvalKernel::Avx2) {
+        EvaluateCellsBothAvx2(game, cells, count, black_scores, white_scores);
+        return;
+    }
+#endif
+    EvaluateCellsScalar(game, cells, count, GomokuGame::kBlack, black_scores);
+    EvaluateCellsScalar(game, cells, count, GomokuGame::kWhite, white_scores);
+}
+
+template <int Size>
+void ClassifyCells(const BasicGomokuGame<Size> &game, const int *cells, int count, CellThreats *threats) {
+#if defined(GOMOKU_AVX2_KERNEL)
+    if (ActiveEvalKernel() == EvalKernel::Avx2) {
+        ClassifyCellsAvx2(game, cells, count, threats);
+        return;
+    }
+#endif
+    ClassifyCellsScalar(game, cells, count, threats);
+}
+
+#define GOMOKU_INSTANTIATE(N)                                                                            \
+    template void EvaluateCells(const BasicGomokuGame<N> &, const int *, int, int, int *);              \
+    template void EvaluateCellsBoth(const BasicGomokuGame<N> &, const int *, int, int *, int *);        \
+    template void ClassifyCells(const BasicGomokuGame<N> &, const int *, int, CellThreats *);
+GOMOKU_FOR_EACH_BOARD_SIZE(GOMOKU_INSTANTIATE)
+#undef GOMOKU_INSTANTIATE
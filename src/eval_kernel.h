@@ -0,0 +1,43 @@
+#ifndef GOMOKU_EVAL_KERNEL_H
+#define GOMOKU_EVAL_KERNEL_H
+
+#include <array>
+
+#include "gomoku.h"
+#include "line_patterns.h"
+
+// Batched line-pattern lookups for candidate scoring and threat search. The
+// AVX2 kernel reads the four line words of a cell with one gather and
+// classifies eight (cell, direction, player) windows per instruction. That
+// is two cells for one player, or one cell for both. The scalar kernel
+// loops over patterns::PatternAt. Both produce identical results; the best
+// kernel the CPU supports is picked on first use.
+enum class EvalKernel {
+    Scalar,
+    Avx2
+};
+
+EvalKernel ActiveEvalKernel();
+// Switches kernels, for benchmarks and comparisons. Returns false, and
+// changes nothing, when the CPU does not support kernel.
+bool SetEvalKernel(EvalKernel kernel);
+const char *EvalKernelName(EvalKernel kernel);
+
+// scores[i] = EvaluateCell(game, cells[i] % Size, cells[i] / Size, player).
+template <int Size>
+void EvaluateCells(const BasicGomokuGame<Size> &game, const int *cells, int count, int player, int *scores);
+// The same for both players at once.
+template <int Size>
+void EvaluateCellsBoth(const BasicGomokuGame<Size> &game, const int *cells, int count, int *black_scores,
+                       int *white_scores);
+
+// Threat class of each direction through an empty cell, by player.
+struct CellThreats {
+    std::array<patterns::Threat, 4> black;
+    std::array<patterns::Threat, 4> white;
+};
+
+template <int Size>
+void ClassifyCells(const BasicGomokuGame<Size> &game, const int *cells, int count, CellThreats *threats);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef GOMOKU_FIXED_LIST_H
+#define GOMOKU_FIXED_LIST_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+// A list with its storage inline, for lists bounded by the number of cells,
+// such as the search's move lists. It never allocates, so the search can
+// copy and grow them freely. Callers keep within Capacity; nothing checks it.
+template <typename T, int Capacity>
+class FixedList {
+public:
+    using value_type = T;
+    using iterator = T *;
+    using const_iterator = const T *;
+
+    static constexpr int capacity() { return Capacity; }
+
+    std::size_t size() const { return static_cast<std::size_t>(size_); }
+    bool empty() const { return size_ == 0; }
+    void clear() { size_ = 0; }
+
+    void push_back(const T &item) { items_[size_++] = item; }
+    template <typename... Args>
+    void emplace_back(Args &&...args) {
+        items_[size_++] = T{static_cast<Args &&>(args)...};
+    }
+    void pop_back() { --size_; }
+
+    T &operator[](std::size_t i) { return items_[i]; }
+    const T &operator[](std::size_t i) const { return items_[i]; }
+    T &front() { return items_[0]; }
+    const T &front() const { return items_[0]; }
+    T &back() { return items_[size_ - 1]; }
+    const T &back() const { return items_[size_ - 1]; }
+
+    T *data() { return items_.data(); }
+    const T *data() const { return items_.data(); }
+    iterator begin() { return items_.data(); }
+    iterator end() { return items_.data() + size_; }
+    const_iterator begin() const { return items_.data(); }
+    const_iterator end() const { return items_.data() + size_; }
+
+    // Moves item to the front, adding it when it is not in the list.
+    void promote(const T &item) {
+        iterator it = std::find(begin(), end(), item);
+        if (it == end()) {
+            push_back(item);
+            it = end() - 1;
+        }
+        std::rotate(begin(), it, it + 1);
+    }
+
+private:
+    std::array<T, Capacity> items_{};
+    int size_ = 0;
+};
+
+#endif
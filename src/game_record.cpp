@@ -0,0 +1,286 @@
+#include "game_record.h"
+
+#include <cstring>
+#include <sstream>
+
+namespace {
+
+constexpr char kMagic[8] = {'G', 'M', 'K', 'G', 'A', 'M', 'E', 'S'};
+constexpr std::size_t kHeaderSize = 16;
+// Board size, rules and result, after the length.
+constexpr std::size_t kRecordHeaderSize = 3;
+constexpr std::size_t kLengthSize = 2;
+// A full 20x20 board at two bytes a move.
+constexpr std::size_t kMaxRecordLength = kRecordHeaderSize + 20 * 20 * 2;
+constexpr int kMaxRules = static_cast<int>(GameRules::Renju);
+constexpr int kMaxResult = static_cast<int>(GameResult::Draw);
+
+std::uint64_t ReadLittle(const unsigned char *bytes, int count) {
+    std::uint64_t value = 0;
+    for (int i = count - 1; i >= 0; --i) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+void WriteLittle(unsigned char *bytes, std::uint64_t value, int count) {
+    for (int i = 0; i < count; ++i) {
+        bytes[i] = static_cast<unsigned char>(value >> (i * 8));
+    }
+}
+
+int CellBytes(int board_size) {
+    return board_size * board_size <= 256 ? 1 : 2;
+}
+
+bool HasHeader(const unsigned char *data, std::size_t size) {
+    return size >= kHeaderSize && std::memcmp(data, kMagic, sizeof(kMagic)) == 0
+        && ReadLittle(data + 8, 4) == GameRecordReader::kVersion;
+}
+
+// Plays the moves on a fresh game; the result is the winner of the last
+// move, a draw on a full board, and unknown otherwise.
+template <int Size>
+bool ReplayResult(const GameRecord &record, GameResult &result) {
+    BasicGomokuGame<Size> game;
+    int player = GomokuGame::kBlack;
+    result = GameResult::Unknown;
+    for (std::size_t i = 0; i < record.moves.size(); ++i) {
+        const auto &move = record.moves[i];
+        if (result != GameResult::Unknown || !game.placeStone(move.first, move.second, player)) {
+            return false;
+        }
+        if (game.checkWin(move.first, move.second, player)) {
+            result = player == GomokuGame::kBlack ? GameResult::BlackWin : GameResult::WhiteWin;
+        } else if (game.isBoardFull()) {
+            result = GameResult::Draw;
+        }
+        player = player == GomokuGame::kBlack ? GomokuGame::kWhite : GomokuGame::kBlack;
+    }
+    return true;
+}
+
+} // namespace
+
+GameRecord GameRecordView::toRecord() const {
+    GameRecord record;
+    record.board_size = board_size_;
+    record.rules = rules_;
+    record.result = result_;
+    record.moves.reserve(move_count_);
+    for (int i = 0; i < move_count_; ++i) {
+        record.moves.push_back(move(i));
+    }
+    return record;
+}
+
+template <int Size>
+bool GameRecordView::replay(BasicGomokuGame<Size> &game) const {
+    game.reset();
+    if (board_size_ != Size) {
+        return false;
+    }
+    int player = GomokuGame::kBlack;
+    for (int i = 0; i < move_count_; ++i) {
+        std::pair<int, int> cell = move(i);
+        if (!game.placeStone(cell.first, cell.second, player)) {
+            return false;
+        }
+        player = player == GomokuGame::kBlack ? GomokuGame::kWhite : GomokuGame::kBlack;
+    }
+    game.setCurrentPlayer(player);
+    return true;
+}
+
+bool GameRecordReader::open(const std::string &path) {
+    close();
+    if (!file_.open(path)) {
+        return false;
+    }
+    if (!HasHeader(file_.data(), file_.size())) {
+        close();
+        return false;
+    }
+    offset_ = kHeaderSize;
+    return true;
+}
+
+void GameRecordReader::close() {
+    file_.close();
+    offset_ = 0;
+    damaged_ = false;
+}
+
+void GameRecordReader::rewind() {
+    offset_ = file_.isOpen() ? kHeaderSize : 0;
+    damaged_ = false;
+}
+
+bool GameRecordReader::next(GameRecordView &view) {
+    if (!file_.isOpen() || damaged_ || offset_ >= file_.size()) {
+        return false;
+    }
+    const unsigned char *record = file_.data() + offset_;
+    std::size_t available = file_.size() - offset_;
+    std::size_t length = available >= kLengthSize ? static_cast<std::size_t>(ReadLittle(record, 2)) : 0;
+    if (length < kRecordHeaderSize || kLengthSize + length > available) {
+        damaged_ = true;
+        return false;
+    }
+    int board_size = record[2];
+    int rules = record[3];
+    int result = record[4];
+    int cell_bytes = CellBytes(board_size);
+    std::size_t cell_length = length - kRecordHeaderSize;
+    if (!IsSupportedBoardSize(board_size) || rules > kMaxRules || result > kMaxResult
+        || cell_length % cell_bytes != 0) {
+        damaged_ = true;
+        return false;
+    }
+    view.cells_ = record + kLengthSize + kRecordHeaderSize;
+    view.cell_bytes_ = cell_bytes;
+    view.board_size_ = board_size;
+    view.move_count_ = static_cast<int>(cell_length / cell_bytes);
+    view.rules_ = static_cast<GameRules>(rules);
+    view.result_ = static_cast<GameResult>(result);
+    for (int i = 0; i < view.move_count_; ++i) {
+        std::pair<int, int> cell = view.move(i);
+        if (cell.second >= board_size) {
+            damaged_ = true;
+            return false;
+        }
+    }
+    offset_ += kLengthSize + length;
+    return true;
+}
+
+GameRecordWriter::~GameRecordWriter() {
+    close();
+}
+
+bool GameRecordWriter::open(const std::string &path) {
+    close();
+    unsigned char header[kHeaderSize] = {};
+    std::size_t existing = 0;
+    if (std::FILE *current = std::fopen(path.c_str(), "rb")) {
+        existing = std::fread(header, 1, sizeof(header), current);
+        std::fclose(current);
+    }
+    if (existing != 0 && !HasHeader(header, existing)) {
+        return false;
+    }
+    file_ = std::fopen(path.c_str(), "ab");
+    if (!file_) {
+        return false;
+    }
+    if (existing == 0) {
+        std::memcpy(header, kMagic, sizeof(kMagic));
+        WriteLittle(header + 8, GameRecordReader::kVersion, 4);
+        WriteLittle(header + 12, 0, 4);
+        if (std::fwrite(header, 1, sizeof(header), file_) != sizeof(header)) {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool GameRecordWriter::append(const GameRecord &record) {
+    const int size = record.board_size;
+    if (!file_ || !IsSupportedBoardSize(size) || record.moves.size() > static_cast<std::size_t>(size * size)) {
+        return false;
+    }
+    const int cell_bytes = CellBytes(size);
+    unsigned char bytes[kLengthSize + kMaxRecordLength];
+    std::size_t length = kRecordHeaderSize + record.moves.size() * cell_bytes;
+    WriteLittle(bytes, length, 2);
+    bytes[2] = static_cast<unsigned char>(size);
+    bytes[3] = static_cast<unsigned char>(record.rules);
+    bytes[4] = static_cast<unsigned char>(record.result);
+    unsigned char *cell = bytes + kLengthSize + kRecordHeaderSize;
+    for (const auto &move : record.moves) {
+        if (move.first < 0 || move.first >= size || move.second < 0 || move.second >= size) {
+            return false;
+        }
+        WriteLittle(cell, static_cast<std::uint64_t>(move.second * size + move.first), cell_bytes);
+        cell += cell_bytes;
+    }
+    return std::fwrite(bytes, 1, kLengthSize + length, file_) == kLengthSize + length;
+}
+
+template <int Size>
+bool GameRecordWriter::append(const BasicGomokuGame<Size> &game, GameResult result, GameRules rules) {
+    GameRecord record;
+    record.board_size = Size;
+    record.rules = rules;
+    record.result = result;
+    int player = GomokuGame::kBlack;
+    for (const Move &move : game.moveHistory()) {
+        if (move.player != player) {
+            return false;
+        }
+        record.moves.emplace_back(move.x, move.y);
+        player = player == GomokuGame::kBlack ? GomokuGame::kWhite : GomokuGame::kBlack;
+    }
+    return append(record);
+}
+
+bool GameRecordWriter::flush() {
+    return file_ && std::fflush(file_) == 0;
+}
+
+bool GameRecordWriter::close() {
+    if (!file_) {
+        return true;
+    }
+    bool closed = std::fclose(file_) == 0;
+    file_ = nullptr;
+    return closed;
+}
+
+bool ParsePsq(const std::string &text, GameRecord &record) {
+    std::istringstream stream(text);
+    std::string line;
+    int width = 0;
+    int height = 0;
+    if (!std::getline(stream, line) || std::sscanf(line.c_str(), "Piskvorky %dx%d", &width, &height) != 2
+        || width != height || !IsSupportedBoardSize(width)) {
+        return false;
+    }
+    record = GameRecord{};
+    record.board_size = width;
+    // Moves run until the first line that is not one; engine names and
+    // other trailers follow.
+    while (std::getline(stream, line)) {
+        int x = 0;
+        int y = 0;
+        int time_ms = 0;
+        if (std::sscanf(line.c_str(), "%d,%d,%d", &x, &y, &time_ms) != 3) {
+            break;
+        }
+        if (x < 1 || x > width || y < 1 || y > width) {
+            return false;
+        }
+        record.moves.emplace_back(x - 1, y - 1);
+    }
+    return WithBoardSize(width, [&](auto size) {
+        return ReplayResult<decltype(size)::value>(record, record.result);
+    });
+}
+
+std::string FormatPsq(const GameRecord &record) {
+    std::ostringstream text;
+    const int cursor = record.board_size / 2 + 1;
+    text << "Piskvorky " << record.board_size << 'x' << record.board_size << ", " << cursor << ':' << cursor
+         << ", 0\n";
+    for (const auto &move : record.moves) {
+        text << move.first + 1 << ',' << move.second + 1 << ",0\n";
+    }
+    return text.str();
+}
+
+#define GOMOKU_INSTANTIATE(N)                                                                                \
+    template bool GameRecordView::replay(BasicGomokuGame<N> &) const;                                       \
+    template bool GameRecordWriter::append(const BasicGomokuGame<N> &, GameResult, GameRules);
+GOMOKU_FOR_EACH_BOARD_SIZE(GOMOKU_INSTANTIATE)
+#undef GOMOKU_INSTANTIATE
@@ -0,0 +1,132 @@
+#ifndef GOMOKU_GAME_RECORD_H
+#define GOMOKU_GAME_RECORD_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gomoku.h"
+#include "mapped_file.h"
+
+// Compact binary archive of finished games, written by appending and read
+// forward from a read-only mapping. Moves alternate, black first, so a move
+// is just its cell: one byte on boards of up to 16x16, two above.
+//
+// File layout, little-endian: a 16-byte header (the magic "GMKGAMES", a
+// uint32 version and a reserved uint32) followed by records. A record is a
+// uint16 length of the rest of the record, then uint8 board size, uint8
+// rules, uint8 result and the cells (y * size + x). There is no index or
+// count, so appending never touches what is already written; a record cut
+// short by a crash ends the file for readers.
+enum class GameResult : std::uint8_t {
+    Unknown,
+    BlackWin,
+    WhiteWin,
+    Draw
+};
+
+enum class GameRules : std::uint8_t {
+    // Five or more in a row wins.
+    Freestyle,
+    // Exactly five wins.
+    Standard,
+    Renju
+};
+
+// A game held in memory, for building records and for text formats.
+struct GameRecord {
+    int board_size = GomokuGame::kBoardSize;
+    GameRules rules = GameRules::Freestyle;
+    GameResult result = GameResult::Unknown;
+    std::vector<std::pair<int, int>> moves;
+};
+
+// A record inside a reader's mapping; valid until the reader is closed.
+class GameRecordView {
+public:
+    int boardSize() const { return board_size_; }
+    GameRules rules() const { return rules_; }
+    GameResult result() const { return result_; }
+    int moveCount() const { return move_count_; }
+    std::pair<int, int> move(int i) const {
+        int cell = cell_bytes_ == 1 ? cells_[i] : cells_[i * 2] | cells_[i * 2 + 1] << 8;
+        return {cell % board_size_, cell / board_size_};
+    }
+
+    GameRecord toRecord() const;
+    // Resets game and plays the moves on it. Returns false when the record
+    // is for another board size or a move is illegal.
+    template <int Size>
+    bool replay(BasicGomokuGame<Size> &game) const;
+
+private:
+    friend class GameRecordReader;
+
+    const unsigned char *cells_ = nullptr;
+    int cell_bytes_ = 1;
+    int board_size_ = GomokuGame::kBoardSize;
+    int move_count_ = 0;
+    GameRules rules_ = GameRules::Freestyle;
+    GameResult result_ = GameResult::Unknown;
+};
+
+// Iterates the records of a file in order, without copying them.
+class GameRecordReader {
+public:
+    static constexpr std::uint32_t kVersion = 1;
+
+    // Maps the file and checks its header; returns false, leaving the
+    // reader closed, when it is missing or not a game-record file.
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const { return file_.isOpen(); }
+
+    // The next record, or false at the end of the file. A malformed or
+    // truncated record also ends the iteration, and sets damaged().
+    bool next(GameRecordView &view);
+    bool damaged() const { return damaged_; }
+    void rewind();
+
+private:
+    MappedFile file_;
+    std::size_t offset_ = 0;
+    bool damaged_ = false;
+};
+
+// Appends records to a file, creating it with a header when it is missing
+// or empty.
+class GameRecordWriter {
+public:
+    GameRecordWriter() = default;
+    ~GameRecordWriter();
+
+    GameRecordWriter(const GameRecordWriter &) = delete;
+    GameRecordWriter &operator=(const GameRecordWriter &) = delete;
+
+    // Returns false when the file cannot be opened or holds something other
+    // than game records.
+    bool open(const std::string &path);
+    // Returns false, writing nothing, when the board size is unsupported or
+    // a move is off the board, and on write errors.
+    bool append(const GameRecord &record);
+    // The game's moves, which must alternate starting with black.
+    template <int Size>
+    bool append(const BasicGomokuGame<Size> &game, GameResult result, GameRules rules = GameRules::Freestyle);
+    bool flush();
+    bool close();
+    bool isOpen() const { return file_ != nullptr; }
+
+private:
+    std::FILE *file_ = nullptr;
+};
+
+// Piskvork's .psq text format: a "Piskvorky WxH, X:Y, 0" header line, then
+// one "x,y,time" line per move with 1-based coordinates. The result is not
+// stored; ParsePsq works it out by replaying the moves, and the rules are
+// taken to be freestyle.
+bool ParsePsq(const std::string &text, GameRecord &record);
+std::string FormatPsq(const GameRecord &record);
+
+#endif
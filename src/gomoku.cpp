@@ -1,40 +1,195 @@
 #include "gomoku.h"
 
-GomokuGame::GomokuGame() {
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+// Keys for the largest board; a smaller board uses the first Size * Size
+// keys of each player, so the standard board keeps the keys it always had.
+constexpr int kMaxBoardSize = 20;
+constexpr int kMaxCellCount = kMaxBoardSize * kMaxBoardSize;
+
+constexpr std::uint64_t SplitMix64(std::uint64_t &state) {
+    state += 0x9E3779B97F4A7C15ULL;
+    std::uint64_t z = state;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr std::array<std::uint64_t, kMaxCellCount * 2> BuildZobristKeys() {
+    std::array<std::uint64_t, kMaxCellCount * 2> keys{};
+    std::uint64_t state = 0x476F6D6F6B75ULL;
+    for (auto &key : keys) {
+        key = SplitMix64(state);
+    }
+    return keys;
+}
+
+constexpr std::array<std::uint64_t, kMaxCellCount * 2> kZobristKeys = BuildZobristKeys();
+
+} // namespace
+
+template <int Size>
+std::uint64_t BasicGomokuGame<Size>::zobristKey(int x, int y, int player) {
+    static_assert(Size <= kMaxBoardSize, "no Zobrist keys for this board size");
+    return kZobristKeys[(player - 1) * kCellCount + y * kBoardSize + x];
+}
+
+template <int Size>
+std::uint64_t BasicGomokuGame<Size>::emptyHash() {
+    if constexpr (Size == GomokuGame::kBoardSize) {
+        return 0;
+    } else {
+        std::uint64_t state = static_cast<std::uint64_t>(Size);
+        return SplitMix64(state);
+    }
+}
+
+template <int Size>
+BasicGomokuGame<Size>::BasicGomokuGame() {
+    moves_.reserve(kCellCount);
     reset();
 }
 
-void GomokuGame::reset() {
+template <int Size>
+void BasicGomokuGame<Size>::reset() {
     for (auto &row : board_) {
         row.fill(kEmpty);
     }
+    lines_.fill(~0ULL);
+    for (int y = 0; y < kBoardSize; ++y) {
+        for (int x = 0; x < kBoardSize; ++x) {
+            setLanes(x, y, bitboard::kLaneEmpty);
+        }
+    }
+    for (auto &rows : stone_rows_) {
+        rows.fill(0);
+    }
+    neighbour_counts_.fill(0);
+    frontier_rows_.fill(0);
+    distance_counts_.fill(0);
+    hash_ = emptyHash();
     current_player_ = kBlack;
     last_move_.reset();
     moves_.clear();
 }
 
-bool GomokuGame::isInside(int x, int y) const {
-    return x >= 0 && x < kBoardSize && y >= 0 && y < kBoardSize;
+template <int Size>
+void BasicGomokuGame<Size>::setLanes(int x, int y, std::uint64_t value) {
+    for (int dir = 0; dir < 4; ++dir) {
+        std::uint64_t &word = lines_[lineIndex(dir, x, y)];
+        int shift = lineLane(dir, x, y) * 2;
+        word = (word & ~(3ULL << shift)) | (value << shift);
+    }
+}
+
+template <int Size>
+void BasicGomokuGame<Size>::addNeighbour(int x, int y, int delta) {
+    for (int ny = y - 2; ny <= y + 2; ++ny) {
+        for (int nx = x - 2; nx <= x + 2; ++nx) {
+            if (!isInside(nx, ny)) {
+                continue;
+            }
+            std::uint8_t &count = neighbour_counts_[ny * kBoardSize + nx];
+            count = static_cast<std::uint8_t>(count + delta);
+            if (board_[ny][nx] != kEmpty) {
+                continue;
+            }
+            if (count == 0) {
+                frontier_rows_[ny] &= ~(1u << nx);
+            } else {
+                frontier_rows_[ny] |= 1u << nx;
+            }
+        }
+    }
+}
+
+template <int Size>
+void BasicGomokuGame<Size>::addDistance(int x, int y, int delta) {
+    for (int dy = -kDistanceReach; dy <= kDistanceReach; ++dy) {
+        int reach = kDistanceReach - std::abs(dy);
+        for (int dx = -reach; dx <= reach; ++dx) {
+            int distance = std::abs(dx) + std::abs(dy);
+            if (distance == 0 || !isInside(x + dx, y + dy)) {
+                continue;
+            }
+            std::uint32_t unit = 1u << ((distance - 1) * 8);
+            std::uint32_t &counts = distance_counts_[(y + dy) * kBoardSize + x + dx];
+            counts = delta > 0 ? counts + unit : counts - unit;
+        }
+    }
 }
 
-bool GomokuGame::placeStone(int x, int y, int player) {
+template <int Size>
+int BasicGomokuGame<Size>::nearestStoneDistance(int x, int y) const {
+    if (board_[y][x] != kEmpty) {
+        return 0;
+    }
+    std::uint32_t counts = distance_counts_[y * kBoardSize + x];
+    if (counts != 0) {
+        return bitboard::CountTrailingZeros(counts) / 8 + 1;
+    }
+    return moves_.empty() ? -1 : scanNearestStone(x, y);
+}
+
+template <int Size>
+int BasicGomokuGame<Size>::scanNearestStone(int x, int y) const {
+    int nearest = -1;
+    for (int row = 0; row < kBoardSize; ++row) {
+        std::uint32_t stones = stone_rows_[0][row] | stone_rows_[1][row];
+        if (stones == 0) {
+            continue;
+        }
+        std::uint32_t left = stones & ((2u << x) - 1);
+        std::uint32_t right = stones >> x;
+        int distance = kBoardSize * 2;
+        if (left != 0) {
+            distance = x - (63 - bitboard::CountLeadingZeros(left));
+        }
+        if (right != 0) {
+            distance = std::min(distance, bitboard::CountTrailingZeros(right));
+        }
+        distance += std::abs(row - y);
+        if (nearest < 0 || distance < nearest) {
+            nearest = distance;
+        }
+    }
+    return nearest;
+}
+
+template <int Size>
+bool BasicGomokuGame<Size>::placeStone(int x, int y, int player) {
     if (!isInside(x, y) || board_[y][x] != kEmpty) {
         return false;
     }
     board_[y][x] = player;
+    setLanes(x, y, static_cast<std::uint64_t>(player));
+    stone_rows_[player - 1][y] |= 1u << x;
+    frontier_rows_[y] &= ~(1u << x);
+    addNeighbour(x, y, 1);
+    addDistance(x, y, 1);
+    hash_ ^= zobristKey(x, y, player);
     Move move{x, y, player};
     moves_.push_back(move);
     last_move_ = move;
     return true;
 }
 
-bool GomokuGame::undoLastMove() {
+template <int Size>
+bool BasicGomokuGame<Size>::undoLastMove() {
     if (moves_.empty()) {
         return false;
     }
     Move move = moves_.back();
     moves_.pop_back();
     board_[move.y][move.x] = kEmpty;
+    setLanes(move.x, move.y, bitboard::kLaneEmpty);
+    stone_rows_[move.player - 1][move.y] &= ~(1u << move.x);
+    addNeighbour(move.x, move.y, -1);
+    addDistance(move.x, move.y, -1);
+    hash_ ^= zobristKey(move.x, move.y, move.player);
     current_player_ = move.player;
     if (moves_.empty()) {
         last_move_.reset();
@@ -44,38 +199,27 @@ bool GomokuGame::undoLastMove() {
     return true;
 }
 
-bool GomokuGame::checkWin(int x, int y, int player) const {
+template <int Size>
+bool BasicGomokuGame<Size>::checkWin(int x, int y, int player) const {
     return findWinningLine(x, y, player).has_value();
 }
 
-std::optional<WinLine> GomokuGame::findWinningLine(int x, int y, int player) const {
-    const int directions[4][2] = {
-        {1, 0}, {0, 1}, {1, 1}, {1, -1}
-    };
-
-    for (const auto &dir : directions) {
-        int count = 1;
-        int count_pos = 0;
-        int count_neg = 0;
-        for (int step = 1; step < 5; ++step) {
-            int nx = x + dir[0] * step;
-            int ny = y + dir[1] * step;
-            if (!isInside(nx, ny) || board_[ny][nx] != player) {
-                break;
+template <int Size>
+std::optional<WinLine> BasicGomokuGame<Size>::findWinningLine(int x, int y, int player) const {
+    for (int dir = 0; dir < 4; ++dir) {
+        std::uint64_t owned = bitboard::OwnedLanes(lineWord(dir, x, y), player);
+        int lane = lineLane(dir, x, y);
+        int count_pos = bitboard::RunAfter(owned, lane);
+        int count_neg = bitboard::RunBefore(owned, lane);
+        if (count_pos + count_neg + 1 >= 5) {
+            if (count_pos > 4) {
+                count_pos = 4;
             }
-            ++count;
-            ++count_pos;
-        }
-        for (int step = 1; step < 5; ++step) {
-            int nx = x - dir[0] * step;
-            int ny = y - dir[1] * step;
-            if (!isInside(nx, ny) || board_[ny][nx] != player) {
-                break;
+            if (count_neg > 4) {
+                count_neg = 4;
             }
-            ++count;
-            ++count_neg;
-        }
-        if (count >= 5) {
+            int dx = bitboard::kDirections[dir][0];
+            int dy = bitboard::kDirections[dir][1];
             int total = count_pos + count_neg + 1;
             int offset_from_start = count_neg;
             int start_offset = offset_from_start - 4;
@@ -85,22 +229,20 @@ std::optional<WinLine> GomokuGame::findWinningLine(int x, int y, int player) con
             if (start_offset > total - 5) {
                 start_offset = total - 5;
             }
-            int start_x = x - dir[0] * count_neg + dir[0] * start_offset;
-            int start_y = y - dir[1] * count_neg + dir[1] * start_offset;
-            return WinLine{start_x, start_y, dir[0], dir[1], 5};
+            int start_x = x - dx * count_neg + dx * start_offset;
+            int start_y = y - dy * count_neg + dy * start_offset;
+            return WinLine{start_x, start_y, dx, dy, 5};
         }
     }
 
     return std::nullopt;
 }
 
-bool GomokuGame::isBoardFull() const {
-    for (const auto &row : board_) {
-        for (int cell : row) {
-            if (cell == kEmpty) {
-                return false;
-            }
-        }
-    }
-    return true;
+template <int Size>
+bool BasicGomokuGame<Size>::isBoardFull() const {
+    return stoneCount() == kBoardSize * kBoardSize;
 }
+
+#define GOMOKU_INSTANTIATE(N) template class BasicGomokuGame<N>;
+GOMOKU_FOR_EACH_BOARD_SIZE(GOMOKU_INSTANTIATE)
+#undef GOMOKU_INSTANTIATE
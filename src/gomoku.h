@@ -2,9 +2,13 @@
 #define GOMOKU_GOMOKU_H
 
 #include <array>
+#include <cstdint>
 #include <optional>
+#include <type_traits>
 #include <vector>
 
+#include "bitboard.h"
+
 struct Move {
     int x = 0;
     int y = 0;
@@ -19,14 +23,26 @@ struct WinLine {
     int length = 0;
 };
 
-class GomokuGame {
+// Board sizes the library is built for. Everything that depends on the
+// size is a template over it, explicitly instantiated once per size in its
+// .cpp file, so each size gets its own constant bounds and tables.
+#define GOMOKU_FOR_EACH_BOARD_SIZE(X) X(15) X(19) X(20)
+
+template <int Size>
+class BasicGomokuGame {
 public:
-    static constexpr int kBoardSize = 15;
+    static constexpr int kBoardSize = Size;
+    static constexpr int kCellCount = Size * Size;
     static constexpr int kEmpty = 0;
     static constexpr int kBlack = 1;
     static constexpr int kWhite = 2;
+    static constexpr int kLineCount = kBoardSize * 2 + (kBoardSize * 2 - 1) * 2;
 
-    GomokuGame();
+    // A line plus its wall padding must fit a line word, and a row a
+    // 32-bit mask.
+    static_assert(Size >= 5 && Size + bitboard::kLinePadding * 2 <= 32, "unsupported board size");
+
+    BasicGomokuGame();
 
     void reset();
     bool placeStone(int x, int y, int player);
@@ -36,6 +52,59 @@ public:
     bool isBoardFull() const;
 
     int at(int x, int y) const { return board_[y][x]; }
+    int stoneCount() const { return static_cast<int>(moves_.size()); }
+    std::uint64_t hash() const { return hash_; }
+    static std::uint64_t zobristKey(int x, int y, int player);
+    // The hash of the empty board. Each size draws its keys from the start
+    // of one shared array, where a key index is a different cell on every
+    // size, so the sizes' hashes start from different values. It is 0 on the
+    // standard board, whose hashes predate the other sizes.
+    static std::uint64_t emptyHash();
+
+    // Packed views of the position, kept in sync by placeStone/undoLastMove.
+    // dir indexes bitboard::kDirections.
+    std::uint64_t lineWord(int dir, int x, int y) const { return lines_[lineIndex(dir, x, y)]; }
+    // All kLineCount words, indexed by lineIndex.
+    const std::uint64_t *lineWords() const { return lines_.data(); }
+    static int lineIndex(int dir, int x, int y) {
+        switch (dir) {
+            case 0:
+                return y;
+            case 1:
+                return kBoardSize + x;
+            case 2:
+                return kBoardSize * 2 + x - y + kBoardSize - 1;
+            default:
+                return kBoardSize * 2 + kBoardSize * 2 - 1 + x + y;
+        }
+    }
+    static int lineLane(int dir, int x, int y) {
+        return (dir == 1 ? y : x) + bitboard::kLinePadding;
+    }
+    std::uint32_t stoneRow(int player, int y) const { return stone_rows_[player - 1][y]; }
+    std::uint32_t occupiedRow(int y) const { return stone_rows_[0][y] | stone_rows_[1][y]; }
+
+    // Candidate frontier: empty cells with at least one stone in the
+    // surrounding 5x5 box. Visiting is allocation-free and row-major.
+    std::uint32_t frontierRow(int y) const { return frontier_rows_[y]; }
+    int neighbourCount(int x, int y) const { return neighbour_counts_[y * kBoardSize + x]; }
+    // Manhattan distance from (x, y) to the nearest stone: 0 on a stone,
+    // -1 on an empty board. Distances up to kDistanceReach are answered from
+    // a field updated around each move; anything farther falls back to a
+    // row scan.
+    static constexpr int kDistanceReach = 4;
+    int nearestStoneDistance(int x, int y) const;
+    template <typename Visitor>
+    void forEachCandidate(Visitor &&visit) const {
+        for (int y = 0; y < kBoardSize; ++y) {
+            std::uint32_t row = frontier_rows_[y];
+            while (row != 0) {
+                int x = bitboard::CountTrailingZeros(row);
+                row &= row - 1;
+                visit(x, y);
+            }
+        }
+    }
     int currentPlayer() const { return current_player_; }
     void setCurrentPlayer(int player) { current_player_ = player; }
 
@@ -44,11 +113,47 @@ public:
 
 private:
     std::array<std::array<int, kBoardSize>, kBoardSize> board_{};
+    std::array<std::uint64_t, kLineCount> lines_{};
+    std::array<std::array<std::uint32_t, kBoardSize>, 2> stone_rows_{};
+    std::array<std::uint8_t, kBoardSize * kBoardSize> neighbour_counts_{};
+    std::array<std::uint32_t, kBoardSize> frontier_rows_{};
+    // One byte per distance 1..kDistanceReach counting stones at that range.
+    std::array<std::uint32_t, kBoardSize * kBoardSize> distance_counts_{};
+    std::uint64_t hash_ = 0;
     int current_player_ = kBlack;
     std::optional<Move> last_move_{};
+    // Reserved for every cell on construction. Assigning a game to another
+    // keeps the target's capacity, so playing on the copy never allocates.
     std::vector<Move> moves_{};
 
-    bool isInside(int x, int y) const;
+    static bool isInside(int x, int y) { return x >= 0 && x < kBoardSize && y >= 0 && y < kBoardSize; }
+    void setLanes(int x, int y, std::uint64_t value);
+    void addNeighbour(int x, int y, int delta);
+    void addDistance(int x, int y, int delta);
+    int scanNearestStone(int x, int y) const;
 };
 
+// The standard board, used by the Windows game and opening books.
+using GomokuGame = BasicGomokuGame<15>;
+
+// Keep these two in step with GOMOKU_FOR_EACH_BOARD_SIZE.
+constexpr bool IsSupportedBoardSize(int size) {
+    return size == 15 || size == 19 || size == 20;
+}
+
+// Calls fn with std::integral_constant<int, size>, so a host picks the
+// board size once and everything below runs on the specialized code.
+// Unsupported sizes get the standard board.
+template <typename Fn>
+decltype(auto) WithBoardSize(int size, Fn &&fn) {
+    switch (size) {
+        case 19:
+            return fn(std::integral_constant<int, 19>{});
+        case 20:
+            return fn(std::integral_constant<int, 20>{});
+        default:
+            return fn(std::integral_constant<int, 15>{});
+    }
+}
+
 #endif
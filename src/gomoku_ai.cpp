@@ -1,42 +1,30 @@
 #include "gomoku_ai.h"
 
+#include "eval_kernel.h"
+#include "fixed_list.h"
+#include "gomoku_eval.h"
+#include "opening_book.h"
+#include "position_cache.h"
+#include "threat_solver.h"
+
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cmath>
-#include <limits>
+#include <cstdint>
 #include <random>
+#include <thread>
 #include <vector>
 
 namespace {
 
-bool IsInside(int x, int y) {
-    return x >= 0 && x < GomokuGame::kBoardSize && y >= 0 && y < GomokuGame::kBoardSize;
-}
-
-bool WouldWin(const GomokuGame &game, int x, int y, int player) {
-    const int directions[4][2] = {
-        {1, 0}, {0, 1}, {1, 1}, {1, -1}
-    };
-
-    for (const auto &dir : directions) {
-        int count = 1;
-        for (int step = 1; step < 5; ++step) {
-            int nx = x + dir[0] * step;
-            int ny = y + dir[1] * step;
-            if (!IsInside(nx, ny) || game.at(nx, ny) != player) {
-                break;
-            }
-            ++count;
-        }
-        for (int step = 1; step < 5; ++step) {
-            int nx = x - dir[0] * step;
-            int ny = y - dir[1] * step;
-            if (!IsInside(nx, ny) || game.at(nx, ny) != player) {
-                break;
-            }
-            ++count;
-        }
-        if (count >= 5) {
+template <int Size>
+bool WouldWin(const BasicGomokuGame<Size> &game, int x, int y, int player) {
+    for (int dir = 0; dir < 4; ++dir) {
+        std::uint64_t owned = bitboard::OwnedLanes(game.lineWord(dir, x, y), player);
+        int lane = game.lineLane(dir, x, y);
+        if (bitboard::RunAfter(owned, lane) + bitboard::RunBefore(owned, lane) + 1 >= 5) {
             return true;
         }
     }
@@ -44,338 +32,1074 @@ bool WouldWin(const GomokuGame &game, int x, int y, int player) {
     return false;
 }
 
-int EvaluateDirection(const GomokuGame &game, int x, int y, int player, int dx, int dy) {
-    int count_pos = 0;
-    int count_neg = 0;
+// Move lists are bounded by the board, so they live on the stack.
+template <int Size>
+using MoveList = FixedList<std::pair<int, int>, Size * Size>;
+
+template <int Size>
+MoveList<Size> GenerateCandidates(const BasicGomokuGame<Size> &game) {
+    MoveList<Size> candidates;
+    game.forEachCandidate([&](int x, int y) {
+        candidates.emplace_back(x, y);
+    });
 
-    int nx = x + dx;
-    int ny = y + dy;
-    while (IsInside(nx, ny) && game.at(nx, ny) == player) {
-        ++count_pos;
-        nx += dx;
-        ny += dy;
+    if (candidates.empty()) {
+        candidates.emplace_back(Size / 2, Size / 2);
     }
-    bool open_pos = IsInside(nx, ny) && game.at(nx, ny) == GomokuGame::kEmpty;
 
-    nx = x - dx;
-    ny = y - dy;
-    while (IsInside(nx, ny) && game.at(nx, ny) == player) {
-        ++count_neg;
-        nx -= dx;
-        ny -= dy;
+    return candidates;
+}
+
+template <int Size>
+int ProximityScore(const BasicGomokuGame<Size> &game, int x, int y) {
+    int distance = game.nearestStoneDistance(x, y);
+    if (distance < 0) {
+        return 0;
     }
-    bool open_neg = IsInside(nx, ny) && game.at(nx, ny) == GomokuGame::kEmpty;
+    return 30 - distance * 2;
+}
+
+// Positional part of a move's static score: a pull towards the centre and
+// towards the stones already played.
+template <int Size>
+int PositionScore(const BasicGomokuGame<Size> &game, int x, int y) {
+    int center_bias = std::abs(x - Size / 2) + std::abs(y - Size / 2);
+    return ProximityScore(game, x, y) - center_bias * 3;
+}
 
-    int total = count_pos + count_neg + 1;
-    int open_ends = static_cast<int>(open_pos) + static_cast<int>(open_neg);
+// Selective search keeps a beam of the best statically scored moves rather
+// than a fixed count: at least kMinBeam, then every move within a factor of
+// kBeamRatio of the best, up to kMaxBeam. A side facing an open three keeps
+// up to kThreatenedBeam moves regardless of score so the defences survive.
+constexpr int kMinBeam = 6;
+constexpr int kMaxBeam = 16;
+constexpr int kThreatenedBeam = 24;
+constexpr int kBeamRatio = 16;
 
-    if (total >= 5) {
-        return 1000000;
+int MaxBeam(bool threatened) {
+    return threatened ? kThreatenedBeam : kMaxBeam;
+}
+
+bool InBeam(int rank, int score, int best_score, bool threatened) {
+    if (rank < kMinBeam) {
+        return true;
     }
-    if (total == 4 && open_ends == 2) {
-        return 120000;
+    if (rank >= MaxBeam(threatened)) {
+        return false;
+    }
+    return threatened || static_cast<long long>(score) * kBeamRatio >= best_score;
+}
+
+// Static scores used to rank moves (cells as y * Size + x): a move's own
+// value and position, plus half the value of the cell to the opponent when
+// the opponent has a threat to answer. The cell values come from the
+// batched evaluator, both players in one pass when both are needed.
+template <int Size>
+void BeamMoveScores(const BasicGomokuGame<Size> &game, const int *cells, int count, int player, bool threatened,
+                    int *scores) {
+    std::array<int, Size * Size> opponent_scores;
+    if (threatened) {
+        int *black = player == GomokuGame::kBlack ? scores : opponent_scores.data();
+        int *white = player == GomokuGame::kBlack ? opponent_scores.data() : scores;
+        EvaluateCellsBoth(game, cells, count, black, white);
+    } else {
+        EvaluateCells(game, cells, count, player, scores);
     }
-    if (total == 4 && open_ends == 1) {
-        return 20000;
+    for (int i = 0; i < count; ++i) {
+        scores[i] += PositionScore(game, cells[i] % Size, cells[i] / Size);
+        if (threatened) {
+            scores[i] += opponent_scores[i] / 2;
+        }
     }
-    if (total == 3 && open_ends == 2) {
-        return 8000;
+}
+
+template <int Size>
+MoveList<Size> SelectTopCandidates(const BasicGomokuGame<Size> &game, int player, bool threatened) {
+    struct ScoredMove {
+        std::pair<int, int> move;
+        int score = 0;
+    };
+    std::array<int, Size * Size> cells;
+    std::array<int, Size * Size> scores;
+    int count = 0;
+    game.forEachCandidate([&](int x, int y) {
+        cells[count++] = y * Size + x;
+    });
+    BeamMoveScores(game, cells.data(), count, player, threatened, scores.data());
+    std::array<ScoredMove, Size * Size> scored;
+    for (int i = 0; i < count; ++i) {
+        scored[i] = {{cells[i] % Size, cells[i] / Size}, scores[i]};
     }
-    if (total == 3 && open_ends == 1) {
-        return 800;
+
+    std::sort(scored.begin(), scored.begin() + count, [](const ScoredMove &a, const ScoredMove &b) {
+        return a.score > b.score;
+    });
+
+    MoveList<Size> top_moves;
+    for (int i = 0; i < count; ++i) {
+        const ScoredMove &entry = scored[i];
+        if (!InBeam(static_cast<int>(top_moves.size()), entry.score, scored.front().score, threatened)) {
+            break;
+        }
+        top_moves.push_back(entry.move);
     }
-    if (total == 2 && open_ends == 2) {
-        return 200;
+    if (top_moves.empty()) {
+        top_moves.emplace_back(Size / 2, Size / 2);
     }
-    if (total == 2 && open_ends == 1) {
-        return 50;
+    return top_moves;
+}
+
+constexpr int kWinScore = 1000000;
+constexpr int kDefaultHardDepth = 3;
+constexpr int kMaxSearchDepth = 32;
+constexpr std::uint64_t kClockCheckInterval = 256;
+constexpr int kMaxSearchThreads = 64;
+constexpr std::uint64_t kRootVcfNodes = 4000;
+constexpr std::uint64_t kRootVctNodes = 1500;
+constexpr std::uint64_t kFrontierVcfNodes = 32;
+constexpr int kKillerSlots = 2;
+// Bounds the window; above any reachable evaluation, and safe to negate.
+constexpr int kInfinity = 1000000000;
+constexpr int kAspirationWindow = 2000;
+constexpr int kAspirationAttempts = 3;
+// Late-move reductions: quiet moves after the first kFullDepthMoves at a node
+// with at least kReductionDepth plies left are searched one ply shallower,
+// two when they come after kDeepReductionMoves with kDeepReductionDepth left
+// and the side to move is not facing an open three.
+constexpr int kFullDepthMoves = 3;
+constexpr int kReductionDepth = 3;
+constexpr int kDeepReductionMoves = 8;
+constexpr int kDeepReductionDepth = 5;
+// Moves that make an open three or better are never reduced.
+constexpr int kThreatMoveScore = 8000;
+// Results within kCachedPlies of the root and at least kMinCachedDepth deep
+// go to the persistent cache, which is also probed there.
+constexpr int kCachedPlies = 4;
+constexpr int kMinCachedDepth = 2;
+// Cache writes are buffered per worker and written out whenever this many
+// are pending, so the buffer is sized once per search.
+constexpr std::size_t kCacheWriteBatch = 4096;
+
+int Opponent(int player) {
+    return GomokuGame::kBlack + GomokuGame::kWhite - player;
+}
+
+// A win completed at ply scores kWinScore plus 100 per ply it saves, so
+// faster wins score higher. Scores beyond kWinScore / 2 are wins or losses.
+int WinScore(int ply) {
+    return kWinScore + (kMaxSearchDepth - ply) * 100;
+}
+
+// Win scores count plies from the root, but a table entry may be read at
+// another ply, so it holds them counted from its own node instead.
+int ScoreToTable(int score, int ply) {
+    if (score >= kWinScore / 2) {
+        return score + ply * 100;
     }
-    if (open_ends == 2) {
-        return 10;
+    if (score <= -kWinScore / 2) {
+        return score - ply * 100;
     }
-    return 2;
+    return score;
 }
 
-int EvaluateCell(const GomokuGame &game, int x, int y, int player) {
-    const int directions[4][2] = {
-        {1, 0}, {0, 1}, {1, 1}, {1, -1}
-    };
-    int score = 0;
-    for (const auto &dir : directions) {
-        score += EvaluateDirection(game, x, y, player, dir[0], dir[1]);
+int ScoreFromTable(int score, int ply) {
+    if (score >= kWinScore / 2) {
+        return score - ply * 100;
+    }
+    if (score <= -kWinScore / 2) {
+        return score + ply * 100;
     }
     return score;
 }
 
-std::vector<std::pair<int, int>> GenerateCandidates(const GomokuGame &game) {
-    std::vector<std::pair<int, int>> candidates;
-    bool hasStone = false;
+using SearchClock = std::chrono::steady_clock;
 
-    for (int y = 0; y < GomokuGame::kBoardSize; ++y) {
-        for (int x = 0; x < GomokuGame::kBoardSize; ++x) {
-            if (game.at(x, y) != GomokuGame::kEmpty) {
-                hasStone = true;
-            }
-        }
-    }
+constexpr std::uint64_t kWhiteToMoveKey = 0x2AF7398005AAA5C7ULL;
 
-    if (!hasStone) {
-        return { {GomokuGame::kBoardSize / 2, GomokuGame::kBoardSize / 2} };
+// Scores are from the side to move's point of view, so the key also
+// encodes whose turn it is.
+template <int Size>
+std::uint64_t NodeKey(const BasicGomokuGame<Size> &game, int player) {
+    std::uint64_t key = game.hash();
+    if (player == GomokuGame::kWhite) {
+        key ^= kWhiteToMoveKey;
     }
+    return key;
+}
 
-    std::array<std::array<bool, GomokuGame::kBoardSize>, GomokuGame::kBoardSize> marked{};
-    for (int y = 0; y < GomokuGame::kBoardSize; ++y) {
-        for (int x = 0; x < GomokuGame::kBoardSize; ++x) {
-            if (game.at(x, y) == GomokuGame::kEmpty) {
-                continue;
+// One worker's state. Everything the worker touches while searching lives
+// here, allocated when the search starts, or in the transposition table, so
+// nodes never allocate.
+template <int Size>
+struct SearchContext {
+    BasicGomokuGame<Size> game;
+    BasicIncrementalEvaluator<Size> eval;
+    // Borrowed from the transposition table for the search.
+    ThreatSolver *threats = nullptr;
+    TranspositionTable *tt = nullptr;
+    PositionCache *cache = nullptr;
+    // Results for the cache, written out in batches of kCacheWriteBatch and
+    // once more after the search.
+    std::vector<CachedPosition> cache_writes;
+    int ai_player = GomokuGame::kBlack;
+    int human_player = GomokuGame::kWhite;
+    std::uint64_t nodes = 0;
+    std::uint64_t node_budget = 0;
+    bool has_deadline = false;
+    SearchClock::time_point deadline{};
+    bool stopped = false;
+    const std::atomic<bool> *stop_signal = nullptr;
+    const CancellationToken *cancel = nullptr;
+    // Main worker only.
+    const std::function<void(const AiSearchResult &)> *on_iteration = nullptr;
+    std::atomic<std::uint64_t> *shared_nodes = nullptr;
+    SearchClock::time_point started{};
+    int root_stones = 0;
+    // Move ordering state, kept across the iterations of one search: quiet
+    // moves that caused a cutoff, per ply, and a history score per player
+    // and cell.
+    std::array<std::array<int, kKillerSlots>, kMaxSearchDepth + 1> killers{};
+    std::array<std::array<int, Size * Size>, 2> history{};
+    // Only written by the kStats instantiations of the search.
+    SearchStats stats;
+
+    // Counts the node and reports whether the search has run out of budget.
+    // Budgets are checked every kClockCheckInterval nodes; with several
+    // workers the node budget applies to their combined count.
+    bool enterNode() {
+        ++nodes;
+        if (stopped) {
+            return true;
+        }
+        if ((stop_signal && stop_signal->load(std::memory_order_relaxed)) || (cancel && cancel->cancelled())) {
+            stopped = true;
+        } else if (nodes % kClockCheckInterval == 0) {
+            std::uint64_t searched = nodes;
+            if (shared_nodes) {
+                searched = shared_nodes->fetch_add(kClockCheckInterval, std::memory_order_relaxed)
+                         + kClockCheckInterval;
             }
-            for (int dy = -2; dy <= 2; ++dy) {
-                for (int dx = -2; dx <= 2; ++dx) {
-                    int nx = x + dx;
-                    int ny = y + dy;
-                    if (!IsInside(nx, ny) || game.at(nx, ny) != GomokuGame::kEmpty) {
-                        continue;
-                    }
-                    if (!marked[ny][nx]) {
-                        marked[ny][nx] = true;
-                        candidates.emplace_back(nx, ny);
-                    }
-                }
+            if ((node_budget != 0 && searched >= node_budget)
+                || (has_deadline && SearchClock::now() >= deadline)) {
+                stopped = true;
             }
         }
+        return stopped;
     }
 
-    if (candidates.empty()) {
-        candidates.emplace_back(GomokuGame::kBoardSize / 2, GomokuGame::kBoardSize / 2);
-    }
-
-    return candidates;
-}
-
-int ProximityScore(const GomokuGame &game, int x, int y) {
-    int min_distance = 1000;
-    for (int row = 0; row < GomokuGame::kBoardSize; ++row) {
-        for (int col = 0; col < GomokuGame::kBoardSize; ++col) {
-            if (game.at(col, row) == GomokuGame::kEmpty) {
-                continue;
-            }
-            int distance = std::abs(col - x) + std::abs(row - y);
-            if (distance < min_distance) {
-                min_distance = distance;
-            }
+    bool makeMove(int x, int y, int player) {
+        if (!game.placeStone(x, y, player)) {
+            return false;
         }
+        eval.update(game, x, y);
+        return true;
     }
-    if (min_distance == 1000) {
-        return 0;
+
+    void undoMove() {
+        Move move = game.moveHistory().back();
+        game.undoLastMove();
+        eval.update(game, move.x, move.y);
     }
-    return 30 - min_distance * 2;
-}
 
-std::vector<std::pair<int, int>> SelectTopCandidates(const GomokuGame &game, int player, int limit) {
-    auto candidates = GenerateCandidates(game);
-    struct ScoredMove {
-        std::pair<int, int> move;
-        int score = 0;
-    };
-    std::vector<ScoredMove> scored;
-    scored.reserve(candidates.size());
+    int ply() const {
+        return std::min(game.stoneCount() - root_stones, kMaxSearchDepth);
+    }
 
-    for (const auto &move : candidates) {
-        int x = move.first;
-        int y = move.second;
-        int score = EvaluateCell(game, x, y, player);
-        int center_bias = std::abs(x - GomokuGame::kBoardSize / 2)
-                        + std::abs(y - GomokuGame::kBoardSize / 2);
-        score -= center_bias * 3;
-        score += ProximityScore(game, x, y);
-        scored.push_back({move, score});
+    void rememberCutoff(int cell, int player, int depth) {
+        std::array<int, kKillerSlots> &slots = killers[ply()];
+        if (slots[0] != cell) {
+            slots[1] = slots[0];
+            slots[0] = cell;
+        }
+        history[player - 1][cell] += depth * depth;
     }
 
-    std::sort(scored.begin(), scored.end(), [](const ScoredMove &a, const ScoredMove &b) {
-        return a.score > b.score;
-    });
+    // Table probe that falls back to the persistent cache near the root; a
+    // cache hit is copied into the table. Scores are converted between the
+    // node-relative form both hold and the root-relative one of the search.
+    bool probe(std::uint64_t key, TranspositionEntry &entry) {
+        bool found = tt->probe(key, entry);
+        if (!found && cache && ply() < kCachedPlies && cache->probe(key, entry)) {
+            tt->store(key, entry.depth, entry.score, entry.bound, entry.move);
+            found = true;
+        }
+        if (found) {
+            entry.score = ScoreFromTable(entry.score, ply());
+        }
+        return found;
+    }
 
-    std::vector<std::pair<int, int>> top_moves;
-    int count = 0;
-    for (const auto &entry : scored) {
-        top_moves.push_back(entry.move);
-        ++count;
-        if (count >= limit) {
-            break;
+    void store(std::uint64_t key, int depth, int score, BoundType bound, int move) {
+        score = ScoreToTable(score, ply());
+        tt->store(key, depth, score, bound, move);
+        if (cache && ply() < kCachedPlies && depth >= kMinCachedDepth) {
+            TranspositionEntry entry;
+            entry.score = score;
+            entry.depth = depth;
+            entry.bound = bound;
+            entry.move = move;
+            cache_writes.push_back(CachedPosition{key, entry});
+            if (cache_writes.size() == kCacheWriteBatch) {
+                cache->store(cache_writes);
+                cache_writes.clear();
+            }
         }
     }
-    if (top_moves.empty() && !candidates.empty()) {
-        top_moves.push_back(candidates.front());
+
+    std::uint64_t nodeKey(int player) const {
+        return NodeKey(game, player);
     }
-    return top_moves;
+};
+
+template <int Size>
+int CellIndex(const std::pair<int, int> &move) {
+    return move.second * Size + move.first;
 }
 
-int EvaluateBoard(const GomokuGame &game, int ai_player, int human_player) {
-    int score = 0;
-    auto candidates = GenerateCandidates(game);
-    for (const auto &move : candidates) {
-        int x = move.first;
-        int y = move.second;
-        score += EvaluateCell(game, x, y, ai_player);
-        score -= EvaluateCell(game, x, y, human_player);
+template <int Size>
+void PromoteMove(MoveList<Size> &moves, int cell) {
+    if (cell >= 0 && cell < Size * Size) {
+        moves.promote({cell % Size, cell / Size});
     }
-    return score;
 }
 
-int Minimax(GomokuGame &game, int depth, bool maximizing, int ai_player, int human_player, int alpha, int beta,
-            int candidate_limit) {
-    if (depth == 0 || game.isBoardFull()) {
-        return EvaluateBoard(game, ai_player, human_player);
+// Hands out a node's moves in stages: the hash move, then an immediate win
+// or the blocks of the opponent's five, then killer moves, then the best
+// quiet candidates by static score, ordered by history. Each stage is built
+// only when the previous one runs dry, so a cutoff on an early move skips
+// the static scoring altogether. When the opponent threatens five and the
+// side to move cannot win at once, only the blocks are generated. The quiet
+// stage keeps only the beam of InBeam.
+template <int Size>
+class MovePicker {
+public:
+    MovePicker(const BasicGomokuGame<Size> &game, int player, int hash_move,
+               const std::array<int, kKillerSlots> &killers, const std::array<int, Size * Size> &history,
+               bool threatened)
+        : game_(game), player_(player), hash_move_(hash_move), killers_(killers), history_(history),
+          threatened_(threatened) {}
+
+    // Next cell index, or -1 when the node has no more moves.
+    int next() {
+        while (true) {
+            switch (stage_) {
+                case Stage::Hash:
+                    stage_ = Stage::Threats;
+                    if (take(hash_move_)) {
+                        return hash_move_;
+                    }
+                    break;
+                case Stage::Threats:
+                    generateThreats();
+                    stage_ = Stage::ThreatMoves;
+                    break;
+                case Stage::ThreatMoves:
+                    while (index_ < count_) {
+                        int cell = moves_[index_++];
+                        if (take(cell)) {
+                            return cell;
+                        }
+                    }
+                    stage_ = forced_ ? Stage::Done : Stage::Killers;
+                    index_ = 0;
+                    break;
+                case Stage::Killers:
+                    while (index_ < kKillerSlots) {
+                        int cell = killers_[index_++];
+                        if (take(cell)) {
+                            return cell;
+                        }
+                    }
+                    stage_ = Stage::Quiet;
+                    generateQuiet();
+                    break;
+                case Stage::Quiet:
+                    while (index_ < count_) {
+                        int cell = moves_[index_++];
+                        if (take(cell)) {
+                            return cell;
+                        }
+                    }
+                    stage_ = Stage::Done;
+                    break;
+                case Stage::Done:
+                    return -1;
+            }
+        }
     }
 
-    int player = maximizing ? ai_player : human_player;
-    auto candidates = SelectTopCandidates(game, player, candidate_limit);
-    if (candidates.empty()) {
-        return EvaluateBoard(game, ai_player, human_player);
+    // Whether the last move came from the killer or quiet stages, i.e. was
+    // not the hash move or a tactical necessity.
+    bool lastWasQuiet() const { return stage_ == Stage::Killers || stage_ == Stage::Quiet; }
+    // Number of quiet moves that were scored, 0 if that stage was never reached.
+    int quietCount() const { return quiet_count_; }
+
+private:
+    enum class Stage {
+        Hash,
+        Threats,
+        ThreatMoves,
+        Killers,
+        Quiet,
+        Done
+    };
+
+    bool take(int cell) {
+        if (cell < 0 || cell >= Size * Size) {
+            return false;
+        }
+        int x = cell % Size;
+        int y = cell / Size;
+        if (game_.at(x, y) != GomokuGame::kEmpty || (taken_[y] >> x) & 1u) {
+            return false;
+        }
+        taken_[y] |= 1u << x;
+        return true;
     }
 
-    if (maximizing) {
-        int best = std::numeric_limits<int>::min();
-        for (const auto &move : candidates) {
-            if (!game.placeStone(move.first, move.second, player)) {
-                continue;
+    void generateThreats() {
+        const int opponent = GomokuGame::kBlack + GomokuGame::kWhite - player_;
+        int wins = 0;
+        int blocks = 0;
+        std::array<int, Size * Size> &block_cells = scores_;
+        game_.forEachCandidate([&](int x, int y) {
+            if (wins == 0 && WouldWin(game_, x, y, player_)) {
+                moves_[wins++] = y * Size + x;
+            } else if (WouldWin(game_, x, y, opponent)) {
+                block_cells[blocks++] = y * Size + x;
             }
-            int score = 0;
-            if (game.findWinningLine(move.first, move.second, player)) {
-                score = 1000000 + depth * 100;
-            } else {
-                score = Minimax(game, depth - 1, false, ai_player, human_player, alpha, beta, candidate_limit);
+        });
+        index_ = 0;
+        if (wins > 0) {
+            count_ = wins;
+            forced_ = true;
+        } else {
+            std::copy(block_cells.begin(), block_cells.begin() + blocks, moves_.begin());
+            count_ = blocks;
+            forced_ = blocks > 0;
+        }
+    }
+
+    void generateQuiet() {
+        count_ = 0;
+        game_.forEachCandidate([&](int x, int y) {
+            int cell = y * Size + x;
+            if ((taken_[y] >> x) & 1u) {
+                return;
+            }
+            moves_[count_++] = cell;
+        });
+        std::array<int, Size * Size> batch;
+        BeamMoveScores(game_, moves_.data(), count_, player_, threatened_, batch.data());
+        for (int i = 0; i < count_; ++i) {
+            scores_[moves_[i]] = batch[i];
+        }
+        int sorted = std::min(count_, MaxBeam(threatened_));
+        std::partial_sort(moves_.begin(), moves_.begin() + sorted, moves_.begin() + count_, [&](int a, int b) {
+            return scores_[a] > scores_[b];
+        });
+        int keep = 0;
+        while (keep < sorted && InBeam(keep, scores_[moves_[keep]], scores_[moves_[0]], threatened_)) {
+            ++keep;
+        }
+        // Stable insertion sort by history: the beam is short, and
+        // std::stable_sort would allocate a buffer at every node.
+        for (int i = 1; i < keep; ++i) {
+            int cell = moves_[i];
+            int j = i;
+            for (; j > 0 && history_[moves_[j - 1]] < history_[cell]; --j) {
+                moves_[j] = moves_[j - 1];
             }
-            game.undoLastMove();
-            if (score > best) {
-                best = score;
+            moves_[j] = cell;
+        }
+        count_ = keep;
+        quiet_count_ = keep;
+        index_ = 0;
+    }
+
+    const BasicGomokuGame<Size> &game_;
+    int player_;
+    int hash_move_;
+    const std::array<int, kKillerSlots> &killers_;
+    const std::array<int, Size * Size> &history_;
+    bool threatened_;
+    Stage stage_ = Stage::Hash;
+    bool forced_ = false;
+    int index_ = 0;
+    int count_ = 0;
+    int quiet_count_ = 0;
+    std::array<std::uint32_t, Size> taken_{};
+    std::array<int, Size * Size> moves_{};
+    std::array<int, Size * Size> scores_{};
+};
+
+// Fail-soft negamax with principal variation search: the first move gets
+// the full window, later ones a null window that is re-opened only when
+// they beat alpha. Scores are from player's point of view.
+template <int Size, bool kStats>
+int Negamax(SearchContext<Size> &ctx, int depth, int player, int alpha, int beta) {
+    BasicGomokuGame<Size> &game = ctx.game;
+    if (ctx.enterNode()) {
+        return 0;
+    }
+    const int opponent = Opponent(player);
+    if (depth == 0 || game.isBoardFull()) {
+        if constexpr (kStats) {
+            ++ctx.stats.leaves;
+        }
+        return ctx.eval.score(player, opponent);
+    }
+
+    const int alpha_orig = alpha;
+    const std::uint64_t key = ctx.nodeKey(player);
+    int hash_move = -1;
+    TranspositionEntry entry;
+    if (ctx.probe(key, entry)) {
+        hash_move = entry.move;
+        if (entry.depth >= depth) {
+            if (entry.bound == BoundType::Exact) {
+                return entry.score;
             }
-            if (best > alpha) {
-                alpha = best;
+            if (entry.bound == BoundType::Lower && entry.score > alpha) {
+                alpha = entry.score;
+            } else if (entry.bound == BoundType::Upper && entry.score < beta) {
+                beta = entry.score;
             }
             if (beta <= alpha) {
-                break;
+                return entry.score;
             }
         }
-        return best;
     }
 
-    int best = std::numeric_limits<int>::max();
-    for (const auto &move : candidates) {
-        if (!game.placeStone(move.first, move.second, player)) {
+    if (depth == 1 && ctx.eval.fourThreats(player) > 0
+        && ctx.threats->solveVcf(game, player, kFrontierVcfNodes).win) {
+        return kWinScore;
+    }
+
+    const bool threatened = ctx.eval.openFourThreats(opponent) > 0;
+    MovePicker<Size> picker(game, player, hash_move, ctx.killers[ctx.ply()], ctx.history[player - 1], threatened);
+
+    int best = -kInfinity;
+    int best_move = -1;
+    int searched = 0;
+    for (int cell = picker.next(); cell >= 0; cell = picker.next()) {
+        int x = cell % Size;
+        int y = cell / Size;
+        int reduction = 0;
+        if (searched >= kFullDepthMoves && depth >= kReductionDepth && picker.lastWasQuiet()
+            && EvaluateCell(game, x, y, player) < kThreatMoveScore) {
+            bool deep = !threatened && searched >= kDeepReductionMoves && depth >= kDeepReductionDepth;
+            reduction = deep ? 2 : 1;
+        }
+        if (!ctx.makeMove(x, y, player)) {
             continue;
         }
+        ++searched;
         int score = 0;
-        if (game.findWinningLine(move.first, move.second, player)) {
-            score = -1000000 - depth * 100;
+        if (game.findWinningLine(x, y, player)) {
+            score = WinScore(ctx.ply());
+        } else if (searched == 1) {
+            score = -Negamax<Size, kStats>(ctx, depth - 1, opponent, -beta, -alpha);
         } else {
-            score = Minimax(game, depth - 1, true, ai_player, human_player, alpha, beta, candidate_limit);
+            score = alpha + 1;
+            if (reduction > 0) {
+                if constexpr (kStats) {
+                    ++ctx.stats.reductions;
+                }
+                score = -Negamax<Size, kStats>(ctx, depth - 1 - reduction, opponent, -alpha - 1, -alpha);
+                if constexpr (kStats) {
+                    ctx.stats.reduction_researches += static_cast<std::uint64_t>(score > alpha);
+                }
+            }
+            if (score > alpha) {
+                score = -Negamax<Size, kStats>(ctx, depth - 1, opponent, -alpha - 1, -alpha);
+            }
+            if (score > alpha && score < beta) {
+                if constexpr (kStats) {
+                    ++ctx.stats.pvs_researches;
+                }
+                score = -Negamax<Size, kStats>(ctx, depth - 1, opponent, -beta, -alpha);
+            }
         }
-        game.undoLastMove();
-        if (score < best) {
+        ctx.undoMove();
+        if (ctx.stopped) {
+            return 0;
+        }
+        if (score > best) {
             best = score;
+            best_move = cell;
         }
-        if (best < beta) {
-            beta = best;
+        if (best > alpha) {
+            alpha = best;
         }
-        if (beta <= alpha) {
+        if (alpha >= beta) {
+            if (picker.lastWasQuiet()) {
+                ctx.rememberCutoff(cell, player, depth);
+            }
+            if constexpr (kStats) {
+                ctx.stats.recordCutoff(searched - 1);
+            }
             break;
         }
     }
-    return best;
-}
+    if constexpr (kStats) {
+        ctx.stats.recordCandidates(picker.quietCount());
+        ++ctx.stats.interior_nodes;
+        ctx.stats.moves_searched += static_cast<std::uint64_t>(searched);
+    }
 
-} // namespace
+    if (best_move < 0) {
+        return ctx.eval.score(player, opponent);
+    }
 
-std::pair<int, int> ComputeAiMove(const GomokuGame &game, int ai_player, int human_player, AiDifficulty difficulty) {
-    auto candidates = GenerateCandidates(game);
+    BoundType bound = BoundType::Exact;
+    if (best <= alpha_orig) {
+        bound = BoundType::Upper;
+    } else if (best >= beta) {
+        bound = BoundType::Lower;
+    }
+    ctx.store(key, depth, best, bound, best_move);
+    return best;
+}
 
-    if (difficulty == AiDifficulty::Easy) {
-        for (const auto &move : candidates) {
-            if (WouldWin(game, move.first, move.second, ai_player)) {
-                return move;
-            }
+// Searches the root moves to the given total depth inside [alpha, beta].
+// Returns false if the budget ran out before the iteration finished;
+// otherwise best_move and best_score hold the result, which is only exact
+// when alpha < best_score < beta.
+template <int Size, bool kStats>
+bool SearchRoot(SearchContext<Size> &ctx, int depth, const MoveList<Size> &root_moves, int alpha, int beta,
+                std::pair<int, int> &best_move, int &best_score) {
+    const int alpha_orig = alpha;
+    int iteration_score = -kInfinity;
+    std::pair<int, int> iteration_move = root_moves.front();
+    int searched = 0;
+    for (const auto &move : root_moves) {
+        if (!ctx.makeMove(move.first, move.second, ctx.ai_player)) {
+            continue;
         }
-        for (const auto &move : candidates) {
-            if (WouldWin(game, move.first, move.second, human_player)) {
-                return move;
+        ++searched;
+        int score = 0;
+        if (ctx.game.findWinningLine(move.first, move.second, ctx.ai_player)) {
+            score = kWinScore;
+        } else if (searched == 1) {
+            score = -Negamax<Size, kStats>(ctx, depth - 1, ctx.human_player, -beta, -alpha);
+        } else {
+            score = -Negamax<Size, kStats>(ctx, depth - 1, ctx.human_player, -alpha - 1, -alpha);
+            if (score > alpha && score < beta) {
+                if constexpr (kStats) {
+                    ++ctx.stats.pvs_researches;
+                }
+                score = -Negamax<Size, kStats>(ctx, depth - 1, ctx.human_player, -beta, -alpha);
             }
         }
-
-        std::mt19937 rng(std::random_device{}());
-        std::uniform_int_distribution<size_t> dist(0, candidates.size() - 1);
-        return candidates[dist(rng)];
+        ctx.undoMove();
+        if (ctx.stopped) {
+            return false;
+        }
+        if (score > iteration_score) {
+            iteration_score = score;
+            iteration_move = move;
+        }
+        if (iteration_score > alpha) {
+            alpha = iteration_score;
+        }
+        if (alpha >= beta) {
+            break;
+        }
+    }
+    BoundType bound = BoundType::Exact;
+    if (iteration_score <= alpha_orig) {
+        bound = BoundType::Upper;
+    } else if (iteration_score >= beta) {
+        bound = BoundType::Lower;
     }
+    ctx.store(ctx.nodeKey(ctx.ai_player), depth, iteration_score, bound, CellIndex<Size>(iteration_move));
+    best_move = iteration_move;
+    best_score = iteration_score;
+    return true;
+}
+
+struct WorkerResult {
+    std::pair<int, int> move{};
+    int score = 0;
+    int depth = 0;
+};
 
-    if (difficulty == AiDifficulty::Hard) {
-        const int candidate_limit = 14;
-        GomokuGame copy = game;
-        auto top_moves = SelectTopCandidates(copy, ai_player, candidate_limit);
-        int best_score = std::numeric_limits<int>::min();
-        std::pair<int, int> best_move = top_moves.front();
-        for (const auto &move : top_moves) {
-            if (!copy.placeStone(move.first, move.second, ai_player)) {
-                continue;
+// Iterative deepening. After the first iteration each depth opens with an
+// aspiration window around the previous score and widens it on a fail low
+// or high; decided positions and repeated failures use the full window.
+template <int Size, bool kStats>
+void Deepen(SearchContext<Size> &ctx, int first_depth, int max_depth, MoveList<Size> root_moves,
+            WorkerResult &result) {
+    for (int depth = first_depth; depth <= max_depth; ++depth) {
+        int delta = kAspirationWindow;
+        bool narrow = result.depth > 0 && std::abs(result.score) < kWinScore / 2;
+        int alpha = narrow ? result.score - delta : -kInfinity;
+        int beta = narrow ? result.score + delta : kInfinity;
+        std::pair<int, int> move;
+        int score = 0;
+        for (int attempt = 1;; ++attempt) {
+            if (!SearchRoot<Size, kStats>(ctx, depth, root_moves, alpha, beta, move, score)) {
+                return;
             }
-            int score = 0;
-            if (copy.findWinningLine(move.first, move.second, ai_player)) {
-                score = 1000000;
-            } else {
-                score = Minimax(copy, 2, false, ai_player, human_player,
-                                std::numeric_limits<int>::min(),
-                                std::numeric_limits<int>::max(),
-                                candidate_limit);
+            if ((score > alpha || alpha == -kInfinity) && (score < beta || beta == kInfinity)) {
+                break;
+            }
+            if constexpr (kStats) {
+                ++ctx.stats.aspiration_failures;
             }
-            copy.undoLastMove();
-            if (score > best_score) {
-                best_score = score;
-                best_move = move;
+            delta *= 4;
+            bool widen_fully = attempt >= kAspirationAttempts;
+            if (score <= alpha) {
+                alpha = widen_fully ? -kInfinity : std::max(-kInfinity, score - delta);
+            } else {
+                beta = widen_fully ? kInfinity : std::min(kInfinity, score + delta);
             }
         }
-        return best_move;
+        result.move = move;
+        result.score = score;
+        result.depth = depth;
+        PromoteMove<Size>(root_moves, CellIndex<Size>(move));
+        double elapsed_ms = std::chrono::duration<double, std::milli>(SearchClock::now() - ctx.started).count();
+        if constexpr (kStats) {
+            ctx.stats.iterations.push_back(SearchIterationStats{depth, elapsed_ms, ctx.nodes});
+        }
+        if (ctx.on_iteration) {
+            AiSearchResult progress;
+            progress.move = move;
+            progress.score = score;
+            progress.depth = depth;
+            progress.nodes = ctx.nodes;
+            progress.elapsed_ms = elapsed_ms;
+            (*ctx.on_iteration)(progress);
+        }
+    }
+}
+
+void MergeStats(const SearchStats &from, SearchStats &into) {
+    into.leaves += from.leaves;
+    into.interior_nodes += from.interior_nodes;
+    into.moves_searched += from.moves_searched;
+    into.cutoffs += from.cutoffs;
+    into.pvs_researches += from.pvs_researches;
+    into.aspiration_failures += from.aspiration_failures;
+    into.reductions += from.reductions;
+    into.reduction_researches += from.reduction_researches;
+    for (int i = 0; i < SearchStats::kCutoffSlots; ++i) {
+        into.cutoff_at[i] += from.cutoff_at[i];
+    }
+    into.candidate_lists += from.candidate_lists;
+    into.candidates_total += from.candidates_total;
+    into.max_candidates = std::max(into.max_candidates, from.max_candidates);
+}
+
+template <int Size, bool kStats>
+AiSearchResult SearchHard(const BasicGomokuGame<Size> &game, int ai_player, int human_player,
+                          const AiSearchOptions &options) {
+    const SearchClock::time_point started = SearchClock::now();
+    const int thread_count = std::max(1, std::min(options.threads, kMaxSearchThreads));
+    std::atomic<bool> stop_signal{false};
+    std::atomic<std::uint64_t> shared_nodes{0};
+    TranspositionTable &table = options.tt ? *options.tt : DefaultTranspositionTable();
+    const TranspositionTable::SolverLease solvers(table, thread_count);
+
+    std::vector<SearchContext<Size>> contexts(thread_count);
+    for (int i = 0; i < thread_count; ++i) {
+        SearchContext<Size> &ctx = contexts[i];
+        ctx.game = game;
+        ctx.eval.reset(ctx.game);
+        ctx.tt = &table;
+        ctx.threats = &solvers.solver(i);
+        if (options.cache && options.cache->isOpen() && options.cache->boardSize() == Size) {
+            ctx.cache = options.cache;
+            ctx.cache_writes.reserve(kCacheWriteBatch);
+        }
+        if constexpr (kStats) {
+            ctx.stats.iterations.reserve(kMaxSearchDepth);
+        }
+        ctx.ai_player = ai_player;
+        ctx.human_player = human_player;
+        ctx.started = started;
+        ctx.root_stones = game.stoneCount();
+        for (auto &slots : ctx.killers) {
+            slots.fill(-1);
+        }
+        ctx.node_budget = options.node_budget;
+        ctx.cancel = options.cancel;
+        if (options.time_budget_ms > 0) {
+            ctx.has_deadline = true;
+            ctx.deadline = started + std::chrono::milliseconds(options.time_budget_ms);
+        }
+        if (thread_count > 1) {
+            ctx.stop_signal = &stop_signal;
+            ctx.shared_nodes = &shared_nodes;
+        }
+    }
+    SearchContext<Size> &main_ctx = contexts.front();
+    main_ctx.tt->newSearch();
+    if (options.on_iteration) {
+        main_ctx.on_iteration = &options.on_iteration;
+    }
+
+    int max_depth = kDefaultHardDepth;
+    if (options.max_depth > 0) {
+        max_depth = std::min(options.max_depth, kMaxSearchDepth);
+    } else if (main_ctx.has_deadline || main_ctx.node_budget != 0) {
+        max_depth = kMaxSearchDepth;
+    }
+
+    AiSearchResult result;
+    // A cached exact result at least as deep as this fixed-depth search
+    // would go answers the position outright.
+    TranspositionEntry cached;
+    if (main_ctx.cache && !main_ctx.has_deadline && main_ctx.node_budget == 0
+        && main_ctx.cache->probe(main_ctx.nodeKey(ai_player), cached) && cached.bound == BoundType::Exact
+        && cached.depth >= max_depth && cached.move >= 0 && cached.move < Size * Size
+        && game.at(cached.move % Size, cached.move / Size) == GomokuGame::kEmpty) {
+        result.move = {cached.move % Size, cached.move / Size};
+        result.score = cached.score;
+        result.depth = cached.depth;
+        return result;
+    }
+
+    auto root_moves =
+        SelectTopCandidates(main_ctx.game, ai_player, main_ctx.eval.openFourThreats(human_player) > 0);
+    TranspositionEntry root_entry;
+    if (main_ctx.probe(main_ctx.nodeKey(ai_player), root_entry)) {
+        PromoteMove<Size>(root_moves, root_entry.move);
+    }
+
+    result.move = root_moves.front();
+    for (const auto &move : root_moves) {
+        if (WouldWin(main_ctx.game, move.first, move.second, ai_player)
+            && main_ctx.game.at(move.first, move.second) == GomokuGame::kEmpty) {
+            result.move = move;
+            result.score = kWinScore;
+            result.depth = 1;
+            return result;
+        }
+    }
+
+    ThreatSearchResult forced_win = main_ctx.threats->solveVcf(main_ctx.game, ai_player, kRootVcfNodes);
+    result.nodes += forced_win.nodes;
+    if (!forced_win.win) {
+        forced_win = main_ctx.threats->solveVct(main_ctx.game, ai_player, kRootVctNodes);
+        result.nodes += forced_win.nodes;
+    }
+    if constexpr (kStats) {
+        options.stats->solver_nodes = result.nodes;
+        options.stats->nodes = result.nodes;
+    }
+    if (forced_win.win) {
+        result.move = forced_win.move;
+        result.score = kWinScore;
+        result.depth = 1;
+        return result;
     }
 
+    // Helpers start on alternating depths so that they fill the table ahead
+    // of the main thread instead of duplicating its work.
+    std::vector<WorkerResult> worker_results(thread_count);
+    std::vector<std::thread> helpers;
+    helpers.reserve(thread_count - 1);
+    for (int i = 1; i < thread_count; ++i) {
+        helpers.emplace_back(Deepen<Size, kStats>, std::ref(contexts[i]), 1 + (i & 1), max_depth, root_moves,
+                             std::ref(worker_results[i]));
+    }
+    Deepen<Size, kStats>(main_ctx, 1, max_depth, root_moves, worker_results.front());
+    stop_signal.store(true, std::memory_order_relaxed);
+    for (std::thread &helper : helpers) {
+        helper.join();
+    }
+
+    const WorkerResult *best = &worker_results.front();
+    for (const WorkerResult &worker : worker_results) {
+        if (worker.depth > best->depth) {
+            best = &worker;
+        }
+    }
+    if (best->depth > 0) {
+        result.move = best->move;
+        result.score = best->score;
+        result.depth = best->depth;
+    }
+    for (const SearchContext<Size> &ctx : contexts) {
+        result.nodes += ctx.nodes;
+        if (ctx.cache) {
+            ctx.cache->store(ctx.cache_writes);
+        }
+    }
+    if constexpr (kStats) {
+        SearchStats &stats = *options.stats;
+        stats.nodes = result.nodes;
+        for (const SearchContext<Size> &ctx : contexts) {
+            MergeStats(ctx.stats, stats);
+        }
+        stats.iterations = main_ctx.stats.iterations;
+    }
+    return result;
+}
+
+template <int Size>
+std::pair<int, int> ComputeEasyMove(const BasicGomokuGame<Size> &game, int ai_player, int human_player) {
+    auto candidates = GenerateCandidates(game);
     for (const auto &move : candidates) {
         if (WouldWin(game, move.first, move.second, ai_player)) {
             return move;
         }
     }
-
-    std::pair<int, int> best_block = candidates.front();
-    int best_block_score = -1;
     for (const auto &move : candidates) {
         if (WouldWin(game, move.first, move.second, human_player)) {
-            int score = EvaluateCell(game, move.first, move.second, human_player);
+            return move;
+        }
+    }
+
+    std::mt19937 rng(std::random_device{}());
+    std::uniform_int_distribution<size_t> dist(0, candidates.size() - 1);
+    return candidates[dist(rng)];
+}
+
+// Static choice without allocating, so batch evaluation can call it per
+// position: win, else block the most valuable of the opponent's wins, else
+// the best cell for both sides.
+template <int Size>
+std::pair<int, int> ComputeNormalMove(const BasicGomokuGame<Size> &game, int ai_player, int human_player) {
+    std::array<int, Size * Size> cells;
+    int count = 0;
+    game.forEachCandidate([&](int x, int y) {
+        cells[count++] = y * Size + x;
+    });
+    if (count == 0) {
+        cells[count++] = (Size / 2) * Size + Size / 2;
+    }
+    for (int i = 0; i < count; ++i) {
+        if (WouldWin(game, cells[i] % Size, cells[i] / Size, ai_player)) {
+            return {cells[i] % Size, cells[i] / Size};
+        }
+    }
+
+    int best_block = cells[0];
+    int best_block_score = -1;
+    for (int i = 0; i < count; ++i) {
+        int x = cells[i] % Size;
+        int y = cells[i] / Size;
+        if (WouldWin(game, x, y, human_player)) {
+            int score = EvaluateCell(game, x, y, human_player);
             if (score > best_block_score) {
                 best_block_score = score;
-                best_block = move;
+                best_block = cells[i];
             }
         }
     }
     if (best_block_score >= 0) {
-        return best_block;
+        return {best_block % Size, best_block / Size};
     }
 
-    int best_score = -1;
-    std::pair<int, int> best_move = candidates.front();
+    std::array<int, Size * Size> black_scores;
+    std::array<int, Size * Size> white_scores;
+    EvaluateCellsBoth(game, cells.data(), count, black_scores.data(), white_scores.data());
+    const auto &ai_scores = ai_player == GomokuGame::kBlack ? black_scores : white_scores;
+    const auto &human_scores = ai_player == GomokuGame::kBlack ? white_scores : black_scores;
 
-    for (const auto &move : candidates) {
-        int x = move.first;
-        int y = move.second;
-        int ai_score = EvaluateCell(game, x, y, ai_player);
-        int human_score = EvaluateCell(game, x, y, human_player);
-        int score = static_cast<int>(ai_score * 1.2 + human_score);
-
-        int center_bias = std::abs(x - GomokuGame::kBoardSize / 2)
-                        + std::abs(y - GomokuGame::kBoardSize / 2);
-        score -= center_bias * 3;
-        score += ProximityScore(game, x, y);
+    int best_score = -1;
+    int best_move = cells[0];
+    for (int i = 0; i < count; ++i) {
+        int score = static_cast<int>(ai_scores[i] * 1.2 + human_scores[i]);
+        score += PositionScore(game, cells[i] % Size, cells[i] / Size);
 
         if (score > best_score) {
             best_score = score;
-            best_move = move;
+            best_move = cells[i];
         }
     }
 
-    return best_move;
+    return {best_move % Size, best_move / Size};
+}
+
+// Books are for the standard board only.
+template <int Size>
+bool ProbeBook(const OpeningBook *book, const BasicGomokuGame<Size> &game, std::pair<int, int> &move) {
+    if constexpr (Size == GomokuGame::kBoardSize) {
+        return book && book->probe(game, move);
+    } else {
+        return false;
+    }
+}
+
+} // namespace
+
+template <int Size>
+bool PredictedReply(const BasicGomokuGame<Size> &game, int player, TranspositionTable &table,
+                    std::pair<int, int> &move) {
+    TranspositionEntry entry;
+    if (!table.probe(NodeKey(game, player), entry) || entry.move < 0 || entry.move >= Size * Size) {
+        return false;
+    }
+    int x = entry.move % Size;
+    int y = entry.move / Size;
+    if (game.at(x, y) != GomokuGame::kEmpty) {
+        return false;
+    }
+    move = {x, y};
+    return true;
 }
+
+TranspositionTable &DefaultTranspositionTable() {
+    static TranspositionTable table;
+    return table;
+}
+
+std::size_t SearchMemoryBytes(int board_size, int threads) {
+    std::size_t worker_bytes = WithBoardSize(board_size, [](auto size) {
+        constexpr int kSize = decltype(size)::value;
+        return sizeof(SearchContext<kSize>) + BasicGomokuGame<kSize>::kCellCount * sizeof(Move);
+    });
+    return worker_bytes * static_cast<std::size_t>(std::max(1, std::min(threads, kMaxSearchThreads)));
+}
+
+template <int Size>
+std::pair<int, int> ComputeAiMove(const BasicGomokuGame<Size> &game, int ai_player, int human_player,
+                                  AiDifficulty difficulty) {
+    return ComputeAiMove(game, ai_player, human_player, difficulty, AiSearchOptions{});
+}
+
+template <int Size>
+std::pair<int, int> ComputeAiMove(const BasicGomokuGame<Size> &game, int ai_player, int human_player,
+                                  AiDifficulty difficulty, const AiSearchOptions &options) {
+    return SearchAiMove(game, ai_player, human_player, difficulty, options).move;
+}
+
+template <int Size>
+AiSearchResult SearchAiMove(const BasicGomokuGame<Size> &game, int ai_player, int human_player,
+                            AiDifficulty difficulty, const AiSearchOptions &options) {
+    auto start = SearchClock::now();
+    if (options.stats) {
+        *options.stats = SearchStats{};
+    }
+    AiSearchResult result;
+    result.move = {Size / 2, Size / 2};
+    if (difficulty == AiDifficulty::Easy) {
+        result.move = ComputeEasyMove(game, ai_player, human_player);
+    } else if (difficulty == AiDifficulty::Normal) {
+        result.move = ComputeNormalMove(game, ai_player, human_player);
+    } else if (ProbeBook(options.book, game, result.move)) {
+        result.from_book = true;
+    } else {
+        result = options.stats ? SearchHard<Size, true>(game, ai_player, human_player, options)
+                               : SearchHard<Size, false>(game, ai_player, human_player, options);
+    }
+    result.elapsed_ms = std::chrono::duration<double, std::milli>(SearchClock::now() - start).count();
+    if (options.stats) {
+        options.stats->elapsed_ms = result.elapsed_ms;
+    }
+    return result;
+}
+
+#define GOMOKU_INSTANTIATE(N)                                                                                   \
+    template bool PredictedReply(const BasicGomokuGame<N> &, int, TranspositionTable &, std::pair<int, int> &); \
+    template std::pair<int, int> ComputeAiMove(const BasicGomokuGame<N> &, int, int, AiDifficulty);             \
+    template std::pair<int, int> ComputeAiMove(const BasicGomokuGame<N> &, int, int, AiDifficulty,              \
+                                               const AiSearchOptions &);                                        \
+    template AiSearchResult SearchAiMove(const BasicGomokuGame<N> &, int, int, AiDifficulty, const AiSearchOptions &);
+GOMOKU_FOR_EACH_BOARD_SIZE(GOMOKU_INSTANTIATE)
+#undef GOMOKU_INSTANTIATE
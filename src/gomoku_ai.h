@@ -1,9 +1,19 @@
 #ifndef GOMOKU_GOMOKU_AI_H
 #define GOMOKU_GOMOKU_AI_H
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <utility>
+#include <vector>
 
 #include "gomoku.h"
+#include "transposition_table.h"
+
+class OpeningBook;
+class PositionCache;
 
 enum class AiDifficulty {
     Easy,
@@ -11,6 +21,140 @@ enum class AiDifficulty {
     Hard
 };
 
-std::pair<int, int> ComputeAiMove(const GomokuGame &game, int ai_player, int human_player, AiDifficulty difficulty);
+struct SearchIterationStats {
+    int depth = 0;
+    double elapsed_ms = 0.0;
+    std::uint64_t nodes = 0;
+};
+
+// Work done by one search, filled in when AiSearchOptions::stats is set.
+// The Hard search is compiled twice, with and without collection, so a
+// search without a stats object pays nothing for it. Counters are summed
+// over all worker threads; iterations come from the main thread and record
+// the time and its cumulative node count when each depth completed. Easy
+// and Normal only report elapsed_ms.
+struct SearchStats {
+    static constexpr int kCutoffSlots = 16;
+
+    std::uint64_t nodes = 0;
+    std::uint64_t leaves = 0;
+    std::uint64_t interior_nodes = 0;
+    std::uint64_t moves_searched = 0;
+    std::uint64_t solver_nodes = 0;
+    std::uint64_t cutoffs = 0;
+    // Cutoffs by the index of the refuting move in the ordered list; the
+    // last slot also counts every later index.
+    std::array<std::uint64_t, kCutoffSlots> cutoff_at{};
+    // Null-window searches that beat alpha and were repeated with the full
+    // window, and root iterations that fell outside the aspiration window.
+    std::uint64_t pvs_researches = 0;
+    std::uint64_t aspiration_failures = 0;
+    // Late moves searched at reduced depth, and those that beat alpha there
+    // and were searched again at full depth.
+    std::uint64_t reductions = 0;
+    std::uint64_t reduction_researches = 0;
+    std::uint64_t candidate_lists = 0;
+    std::uint64_t candidates_total = 0;
+    int max_candidates = 0;
+    std::vector<SearchIterationStats> iterations;
+    double elapsed_ms = 0.0;
+
+    void recordCutoff(int index) {
+        ++cutoffs;
+        ++cutoff_at[index < kCutoffSlots ? index : kCutoffSlots - 1];
+    }
+    void recordCandidates(int count) {
+        ++candidate_lists;
+        candidates_total += static_cast<std::uint64_t>(count);
+        max_candidates = count > max_candidates ? count : max_candidates;
+    }
+    double averageCandidates() const {
+        return candidate_lists == 0 ? 0.0 : static_cast<double>(candidates_total) / candidate_lists;
+    }
+    // Children actually searched per expanded node, after cutoffs.
+    double effectiveBranchingFactor() const {
+        return interior_nodes == 0 ? 0.0 : static_cast<double>(moves_searched) / interior_nodes;
+    }
+    // Share of cutoffs produced by the first move searched.
+    double firstMoveCutoffRate() const {
+        return cutoffs == 0 ? 0.0 : static_cast<double>(cutoff_at[0]) / cutoffs;
+    }
+};
+
+struct AiSearchResult {
+    std::pair<int, int> move{GomokuGame::kBoardSize / 2, GomokuGame::kBoardSize / 2};
+    int score = 0;
+    int depth = 0;
+    std::uint64_t nodes = 0;
+    double elapsed_ms = 0.0;
+    // The move came from AiSearchOptions::book; depth and nodes are 0.
+    bool from_book = false;
+};
+
+// Asks a running search to stop. The search checks it at every node and
+// returns the best move of its last completed iteration.
+class CancellationToken {
+public:
+    void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+    void reset() { cancelled_.store(false, std::memory_order_relaxed); }
+    bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> cancelled_{false};
+};
+
+struct AiSearchOptions {
+    // Table shared across calls; nullptr uses DefaultTranspositionTable().
+    TranspositionTable *tt = nullptr;
+    // Hard only. With no budget and no max_depth the search runs to the
+    // default depth. A budget (0 = unlimited) makes the search deepen
+    // iteratively until it runs out, up to max_depth when that is set.
+    int time_budget_ms = 0;
+    std::uint64_t node_budget = 0;
+    int max_depth = 0;
+    // Hard only. Worker threads searching the same root and sharing the
+    // transposition table (Lazy SMP); 1 keeps the search single-threaded.
+    int threads = 1;
+    // Optional; reset and filled in by the search when set.
+    SearchStats *stats = nullptr;
+    // Hard only, and only on the standard board. Probed before anything
+    // else; a hit is played without searching.
+    const OpeningBook *book = nullptr;
+    // Hard only. Persistent results probed near the root when the table
+    // misses; the search's own results near the root are added once it
+    // finishes. A fixed-depth search whose root is cached deep enough
+    // returns the cached move without searching. Ignored when it was opened
+    // for another board size.
+    PositionCache *cache = nullptr;
+    // Hard only. Stops the search early when cancelled.
+    const CancellationToken *cancel = nullptr;
+    // Hard only. Called on the searching thread whenever the main worker
+    // completes an iteration, with the best move so far.
+    std::function<void(const AiSearchResult &)> on_iteration;
+};
+
+// Instantiated for every size in GOMOKU_FOR_EACH_BOARD_SIZE.
+template <int Size>
+std::pair<int, int> ComputeAiMove(const BasicGomokuGame<Size> &game, int ai_player, int human_player,
+                                  AiDifficulty difficulty);
+template <int Size>
+std::pair<int, int> ComputeAiMove(const BasicGomokuGame<Size> &game, int ai_player, int human_player,
+                                  AiDifficulty difficulty, const AiSearchOptions &options);
+template <int Size>
+AiSearchResult SearchAiMove(const BasicGomokuGame<Size> &game, int ai_player, int human_player,
+                            AiDifficulty difficulty, const AiSearchOptions &options);
+
+// The move the table holds for player to move in game, left there by an
+// earlier search; false when there is none.
+template <int Size>
+bool PredictedReply(const BasicGomokuGame<Size> &game, int player, TranspositionTable &table,
+                    std::pair<int, int> &move);
+
+TranspositionTable &DefaultTranspositionTable();
+
+// Memory a Hard search on a board_size board allocates for its workers while
+// it runs, without a persistent cache or statistics. The transposition table
+// and the threat solvers it keeps are counted separately.
+std::size_t SearchMemoryBytes(int board_size, int threads);
 
 #endif
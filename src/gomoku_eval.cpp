@@ -0,0 +1,121 @@
+#include "gomoku_eval.h"
+
+#include "line_patterns.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+// Lowest direction score of a move that makes a four or better.
+constexpr int kFourScore = patterns::kLevelScores[6];
+constexpr int kOpenFourScore = patterns::kLevelScores[7];
+
+template <int Size>
+bool IsInside(int x, int y) {
+    return x >= 0 && x < Size && y >= 0 && y < Size;
+}
+
+} // namespace
+
+template <int Size>
+int EvaluateDirection(const BasicGomokuGame<Size> &game, int x, int y, int player, int dir) {
+    patterns::LinePattern pattern =
+        patterns::PatternAt(game.lineWord(dir, x, y), BasicGomokuGame<Size>::lineLane(dir, x, y), player);
+    return patterns::kLevelScores[pattern.level];
+}
+
+template <int Size>
+int EvaluateCell(const BasicGomokuGame<Size> &game, int x, int y, int player) {
+    int score = 0;
+    for (int dir = 0; dir < 4; ++dir) {
+        score += EvaluateDirection(game, x, y, player, dir);
+    }
+    return score;
+}
+
+template <int Size>
+void BasicIncrementalEvaluator<Size>::reset(const Game &game) {
+    for (auto &dir_cells : cells_) {
+        dir_cells.fill(Score{});
+    }
+    lines_.fill(Score{});
+    totals_.fill(0);
+    four_threats_.fill(0);
+    open_four_threats_.fill(0);
+    for (int y = 0; y < Size; ++y) {
+        candidate_rows_[y] = game.frontierRow(y);
+    }
+    // Everything else scores zero, as it was just cleared to.
+    game.forEachCandidate([&](int x, int y) {
+        for (int dir = 0; dir < 4; ++dir) {
+            rescoreCell(game, dir, x, y);
+        }
+    });
+}
+
+template <int Size>
+void BasicIncrementalEvaluator<Size>::update(const Game &game, int x, int y) {
+    const int top = std::max(0, y - 2);
+    const int bottom = std::min(Size - 1, y + 2);
+    std::array<std::uint32_t, 5> toggled{};
+    for (int ny = top; ny <= bottom; ++ny) {
+        std::uint32_t row = game.frontierRow(ny);
+        toggled[ny - top] = row ^ candidate_rows_[ny];
+        candidate_rows_[ny] = row;
+    }
+
+    for (int dir = 0; dir < 4; ++dir) {
+        int dx = bitboard::kDirections[dir][0];
+        int dy = bitboard::kDirections[dir][1];
+        for (int step = -kReach; step <= kReach; ++step) {
+            int nx = x + dx * step;
+            int ny = y + dy * step;
+            if (IsInside<Size>(nx, ny)) {
+                rescoreCell(game, dir, nx, ny);
+            }
+        }
+    }
+
+    for (int ny = top; ny <= bottom; ++ny) {
+        std::uint32_t changed = toggled[ny - top];
+        while (changed != 0) {
+            int nx = bitboard::CountTrailingZeros(changed);
+            changed &= changed - 1;
+            for (int dir = 0; dir < 4; ++dir) {
+                if (Game::lineIndex(dir, nx, ny) != Game::lineIndex(dir, x, y)) {
+                    rescoreCell(game, dir, nx, ny);
+                }
+            }
+        }
+    }
+}
+
+template <int Size>
+void BasicIncrementalEvaluator<Size>::rescoreCell(const Game &game, int dir, int x, int y) {
+    Score fresh{};
+    if (isCandidate(x, y)) {
+        fresh.black = EvaluateDirection(game, x, y, Game::kBlack, dir);
+        fresh.white = EvaluateDirection(game, x, y, Game::kWhite, dir);
+    }
+    Score &cell = cells_[dir][y * Size + x];
+    Score &line = lines_[Game::lineIndex(dir, x, y)];
+    line.black += fresh.black - cell.black;
+    line.white += fresh.white - cell.white;
+    totals_[0] += fresh.black - cell.black;
+    totals_[1] += fresh.white - cell.white;
+    four_threats_[0] += static_cast<int>(fresh.black >= kFourScore) - static_cast<int>(cell.black >= kFourScore);
+    four_threats_[1] += static_cast<int>(fresh.white >= kFourScore) - static_cast<int>(cell.white >= kFourScore);
+    open_four_threats_[0] += static_cast<int>(fresh.black >= kOpenFourScore)
+                           - static_cast<int>(cell.black >= kOpenFourScore);
+    open_four_threats_[1] += static_cast<int>(fresh.white >= kOpenFourScore)
+                           - static_cast<int>(cell.white >= kOpenFourScore);
+    cell = fresh;
+}
+
+#define GOMOKU_INSTANTIATE(N)                                                                         \
+    template int EvaluateDirection(const BasicGomokuGame<N> &, int, int, int, int);                  \
+    template int EvaluateCell(const BasicGomokuGame<N> &, int, int, int);                            \
+    template class BasicIncrementalEvaluator<N>;
+GOMOKU_FOR_EACH_BOARD_SIZE(GOMOKU_INSTANTIATE)
+#undef GOMOKU_INSTANTIATE
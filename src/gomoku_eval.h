@@ -0,0 +1,60 @@
+#ifndef GOMOKU_GOMOKU_EVAL_H
+#define GOMOKU_GOMOKU_EVAL_H
+
+#include <array>
+#include <cstdint>
+
+#include "gomoku.h"
+
+template <int Size>
+int EvaluateDirection(const BasicGomokuGame<Size> &game, int x, int y, int player, int dir);
+template <int Size>
+int EvaluateCell(const BasicGomokuGame<Size> &game, int x, int y, int player);
+
+// Maintains the sum of EvaluateCell over the game's candidate frontier, for
+// both players, split into per-line scores. A stone only changes
+// the direction scores of cells up to five lanes away on its own four lines,
+// plus the cells whose candidate status it toggles, so update() rescans just
+// those. Call update after placeStone or undoLastMove on the same game.
+template <int Size>
+class BasicIncrementalEvaluator {
+public:
+    using Game = BasicGomokuGame<Size>;
+
+    void reset(const Game &game);
+    void update(const Game &game, int x, int y);
+
+    int total(int player) const { return totals_[player - 1]; }
+    int score(int player, int opponent) const { return total(player) - total(opponent); }
+    int lineScore(int line, int player) const {
+        return player == Game::kBlack ? lines_[line].black : lines_[line].white;
+    }
+    // Number of (candidate cell, direction) pairs where player would make
+    // at least a four; zero means the player has no four to play.
+    int fourThreats(int player) const { return four_threats_[player - 1]; }
+    // Same, for open fours: nonzero when the player has an open three (or
+    // better) on the board.
+    int openFourThreats(int player) const { return open_four_threats_[player - 1]; }
+
+private:
+    static constexpr int kReach = 5;
+
+    struct Score {
+        int black = 0;
+        int white = 0;
+    };
+
+    void rescoreCell(const Game &game, int dir, int x, int y);
+    bool isCandidate(int x, int y) const { return (candidate_rows_[y] >> x) & 1u; }
+
+    std::array<std::array<Score, Game::kCellCount>, 4> cells_{};
+    std::array<Score, Game::kLineCount> lines_{};
+    std::array<std::uint32_t, Size> candidate_rows_{};
+    std::array<int, 2> totals_{};
+    std::array<int, 2> four_threats_{};
+    std::array<int, 2> open_four_threats_{};
+};
+
+using IncrementalEvaluator = BasicIncrementalEvaluator<GomokuGame::kBoardSize>;
+
+#endif
@@ -0,0 +1,385 @@
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "engine_host.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#endif
+
+// Runs many games on one pool of search threads, speaking EngineHost's line
+// protocol on stdin/stdout or, on POSIX systems, to any number of clients
+// on a Unix socket.
+namespace {
+
+struct HostArguments {
+    HostOptions host;
+    std::string socket_path;
+};
+
+void PrintUsage(const char *program) {
+    std::fprintf(stderr,
+                 "usage: %s [options]\n"
+                 "  --workers N        search threads shared by all sessions (default: hardware threads)\n"
+                 "  --queue N          searches that may wait for a thread before go answers busy (default 256)\n"
+                 "  --memory-mb N      memory limit for all sessions together (default 1024)\n"
+                 "  --hash-mb N        transposition table size of a new session (default 1)\n"
+                 "  --time-ms N        time per move of a new session (default 1000)\n"
+                 "  --max-time-ms N    longest time per move a session may ask for (default 60000)\n"
+                 "  --socket PATH      serve clients on a Unix socket instead of stdin/stdout\n"
+                 "Send \"stats\" for per-request latency percentiles; see src/engine_host.h for the protocol.\n",
+                 program);
+}
+
+bool ParseNumber(const char *text, long long min_value, long long &value) {
+    char *end = nullptr;
+    long long parsed = std::strtoll(text, &end, 10);
+    if (end == text || *end != '\0' || parsed < min_value) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+bool ParseArguments(int argc, char **argv, HostArguments &arguments) {
+    HostOptions &host = arguments.host;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        long long number = 0;
+        if (arg == "--socket" && has_value) {
+            arguments.socket_path = argv[++i];
+        } else if (arg == "--workers" && has_value && ParseNumber(argv[++i], 0, number)) {
+            host.workers = static_cast<int>(number);
+        } else if (arg == "--queue" && has_value && ParseNumber(argv[++i], 1, number)) {
+            host.queue_capacity = static_cast<std::size_t>(number);
+        } else if (arg == "--memory-mb" && has_value && ParseNumber(argv[++i], 1, number)) {
+            host.memory_mb = static_cast<std::size_t>(number);
+        } else if (arg == "--hash-mb" && has_value && ParseNumber(argv[++i], 1, number)) {
+            host.session_hash_mb = static_cast<std::size_t>(number);
+        } else if (arg == "--time-ms" && has_value && ParseNumber(argv[++i], 1, number)) {
+            host.time_ms = static_cast<int>(number);
+        } else if (arg == "--max-time-ms" && has_value && ParseNumber(argv[++i], 1, number)) {
+            host.max_time_ms = static_cast<int>(number);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PrintLatency(const EngineHost &host) {
+    LatencySummary summary = host.latency();
+    std::fprintf(stderr, "requests %llu p50_ms %.2f p99_ms %.2f max_ms %.2f\n",
+                 static_cast<unsigned long long>(summary.requests), summary.p50_ms, summary.p99_ms, summary.max_ms);
+}
+
+// At the end of input the searches already asked for still answer; quit
+// ends at once.
+int ServeStdio(EngineHost &host) {
+    int connection = host.connect([](const std::string &line) {
+        std::printf("%s\n", line.c_str());
+        std::fflush(stdout);
+    });
+    std::string line;
+    bool quit = false;
+    while (!quit && std::getline(std::cin, line)) {
+        quit = !host.handle(connection, line);
+    }
+    if (!quit) {
+        host.wait(connection);
+    }
+    host.disconnect(connection);
+    return 0;
+}
+
+#ifdef _WIN32
+
+int ServeSocket(EngineHost &, const std::string &) {
+    std::fprintf(stderr, "--socket is not supported on Windows\n");
+    return 2;
+}
+
+#else
+
+// Replies not yet written are dropped with the client beyond this, so a
+// client that stops reading cannot grow the host without bound.
+constexpr std::size_t kMaxPendingOutput = 1 << 20;
+// Likewise for a client's input: a line longer than this is never a
+// command, and the client is dropped rather than buffered further.
+constexpr std::size_t kMaxPendingInput = 1 << 20;
+
+volatile std::sig_atomic_t g_stop = 0;
+// Write end of the pipe that wakes the poll loop.
+int g_wake_fd = -1;
+
+void Wake() {
+    char byte = 0;
+    // Nothing to do when the pipe is full: the loop is due to wake anyway.
+    [[maybe_unused]] ssize_t written = ::write(g_wake_fd, &byte, 1);
+}
+
+void OnSignal(int) {
+    g_stop = 1;
+    Wake();
+}
+
+bool SetNonBlocking(int fd) {
+    int flags = ::fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+// Replies waiting for a client's socket to take them. Search threads append;
+// only the poll loop writes to the socket, so no thread ever blocks on a
+// client.
+struct Output {
+    std::mutex mutex;
+    std::string data;
+    bool overflowed = false;
+};
+
+struct Client {
+    int connection = 0;
+    std::string pending;
+    std::shared_ptr<Output> output = std::make_shared<Output>();
+    // Disconnected from the host; the socket closes once its replies are out.
+    bool closing = false;
+};
+
+void Queue(Output &output, const std::string &line) {
+    bool was_empty = false;
+    {
+        std::lock_guard<std::mutex> lock(output.mutex);
+        if (output.overflowed) {
+            return;
+        }
+        if (output.data.size() + line.size() + 1 > kMaxPendingOutput) {
+            output.overflowed = true;
+        } else {
+            was_empty = output.data.empty();
+            output.data += line;
+            output.data += '\n';
+        }
+    }
+    if (was_empty || output.overflowed) {
+        Wake();
+    }
+}
+
+// Writes what the socket takes without blocking; false once the client is
+// gone.
+bool Flush(int fd, Output &output) {
+    std::lock_guard<std::mutex> lock(output.mutex);
+    std::size_t written = 0;
+    while (written < output.data.size()) {
+        ssize_t count = ::send(fd, output.data.data() + written, output.data.size() - written, MSG_NOSIGNAL);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                return false;
+            }
+            break;
+        }
+        written += static_cast<std::size_t>(count);
+    }
+    output.data.erase(0, written);
+    return true;
+}
+
+bool HasOutput(Output &output) {
+    std::lock_guard<std::mutex> lock(output.mutex);
+    return !output.data.empty();
+}
+
+bool Overflowed(Output &output) {
+    std::lock_guard<std::mutex> lock(output.mutex);
+    return output.overflowed;
+}
+
+// Serves until SIGINT or SIGTERM. Client sockets are non-blocking: replies,
+// from search threads as well as this one, are buffered per client and
+// written here when the socket has room.
+int ServeSocket(EngineHost &host, const std::string &path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::fprintf(stderr, "socket path %s is too long\n", path.c_str());
+        return 2;
+    }
+    // A socket left behind by an earlier run is replaced; anything else at
+    // the path is left alone.
+    struct stat existing {};
+    if (::lstat(path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode) || ::unlink(path.c_str()) != 0) {
+            std::fprintf(stderr, "%s exists and is not a socket\n", path.c_str());
+            return 1;
+        }
+    }
+    int wake_pipe[2] = {-1, -1};
+    if (::pipe(wake_pipe) != 0 || !SetNonBlocking(wake_pipe[0]) || !SetNonBlocking(wake_pipe[1])) {
+        std::fprintf(stderr, "cannot create a pipe: %s\n", std::strerror(errno));
+        return 1;
+    }
+    g_wake_fd = wake_pipe[1];
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    if (listener < 0 || ::bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0
+        || ::listen(listener, 64) != 0) {
+        std::fprintf(stderr, "cannot listen on %s: %s\n", path.c_str(), std::strerror(errno));
+        if (listener >= 0) {
+            ::close(listener);
+        }
+        ::close(wake_pipe[0]);
+        ::close(wake_pipe[1]);
+        return 1;
+    }
+    std::signal(SIGINT, OnSignal);
+    std::signal(SIGTERM, OnSignal);
+
+    std::map<int, Client> clients;
+    auto close_client = [&](int fd) {
+        Client &client = clients[fd];
+        if (!client.closing) {
+            host.disconnect(client.connection);
+        }
+        clients.erase(fd);
+        ::close(fd);
+    };
+    // Once disconnect returns no more replies arrive; the rest of the
+    // buffer still goes out before the socket closes.
+    auto finish = [&](int fd) {
+        Client &client = clients[fd];
+        host.disconnect(client.connection);
+        client.closing = true;
+        client.pending.clear();
+    };
+    std::vector<pollfd> polled;
+    std::vector<int> closed;
+    while (!g_stop) {
+        polled.assign({pollfd{listener, POLLIN, 0}, pollfd{wake_pipe[0], POLLIN, 0}});
+        closed.clear();
+        for (const auto &entry : clients) {
+            const Client &client = entry.second;
+            bool has_output = HasOutput(*client.output);
+            if (Overflowed(*client.output) || (client.closing && !has_output)) {
+                closed.push_back(entry.first);
+                continue;
+            }
+            short events = client.closing ? 0 : POLLIN;
+            polled.push_back(pollfd{entry.first, static_cast<short>(has_output ? events | POLLOUT : events), 0});
+        }
+        for (int fd : closed) {
+            close_client(fd);
+        }
+        if (::poll(polled.data(), polled.size(), -1) < 0) {
+            continue;
+        }
+        if (polled[1].revents & POLLIN) {
+            char drained[64];
+            while (::read(wake_pipe[0], drained, sizeof(drained)) > 0) {
+            }
+        }
+        if (polled[0].revents & POLLIN) {
+            int fd = ::accept(listener, nullptr, nullptr);
+            if (fd >= 0 && SetNonBlocking(fd)) {
+                Client &client = clients[fd];
+                std::shared_ptr<Output> output = client.output;
+                client.connection = host.connect([output](const std::string &line) { Queue(*output, line); });
+            } else if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+        for (std::size_t i = 2; i < polled.size(); ++i) {
+            if (polled[i].revents == 0) {
+                continue;
+            }
+            int fd = polled[i].fd;
+            Client &client = clients[fd];
+            if ((polled[i].revents & POLLOUT) && !Flush(fd, *client.output)) {
+                close_client(fd);
+                continue;
+            }
+            if (client.closing) {
+                if (polled[i].revents & (POLLHUP | POLLERR)) {
+                    close_client(fd);
+                }
+                continue;
+            }
+            if ((polled[i].revents & (POLLIN | POLLHUP | POLLERR)) == 0) {
+                continue;
+            }
+            char buffer[4096];
+            ssize_t count = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+                continue;
+            }
+            if (count <= 0) {
+                finish(fd);
+                continue;
+            }
+            client.pending.append(buffer, static_cast<std::size_t>(count));
+            bool open = true;
+            std::size_t end = 0;
+            while (open && (end = client.pending.find('\n')) != std::string::npos) {
+                std::string line = client.pending.substr(0, end);
+                client.pending.erase(0, end + 1);
+                open = host.handle(client.connection, line);
+            }
+            if (!open) {
+                finish(fd);
+            } else if (client.pending.size() > kMaxPendingInput) {
+                close_client(fd);
+            }
+        }
+    }
+    // Shutting down: one last try at each client's replies.
+    while (!clients.empty()) {
+        int fd = clients.begin()->first;
+        Client &client = clients.begin()->second;
+        if (!client.closing) {
+            host.disconnect(client.connection);
+            client.closing = true;
+        }
+        Flush(fd, *client.output);
+        close_client(fd);
+    }
+    ::close(listener);
+    ::unlink(path.c_str());
+    g_wake_fd = -1;
+    ::close(wake_pipe[0]);
+    ::close(wake_pipe[1]);
+    return 0;
+}
+
+#endif
+
+} // namespace
+
+int main(int argc, char **argv) {
+    HostArguments arguments;
+    if (!ParseArguments(argc, argv, arguments)) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+    EngineHost host(arguments.host);
+    int status = arguments.socket_path.empty() ? ServeStdio(host) : ServeSocket(host, arguments.socket_path);
+    PrintLatency(host);
+    return status;
+}
@@ -0,0 +1,205 @@
+#ifndef GOMOKU_LINE_PATTERNS_H
+#define GOMOKU_LINE_PATTERNS_H
+
+#include <array>
+#include <cstdint>
+
+#include "bitboard.h"
+
+// Compile-time tables that classify the nine-lane window around a cell in
+// one direction, as if the player owned the centre lane. Each side of the
+// centre contributes four lanes, read as ternary digits relative to the
+// player (0 empty, 1 own stone, 2 opponent or wall), so a window is one of
+// 81 * 81 codes and its score level and threat class are a single lookup.
+namespace patterns {
+
+enum class Threat : std::uint8_t {
+    None,
+    Three,
+    OpenThree,
+    Four,
+    OpenFour,
+    Five
+};
+
+struct LinePattern {
+    std::uint8_t level = 0;
+    Threat threat = Threat::None;
+};
+
+constexpr int kSideLanes = 4;
+constexpr int kWindowLanes = kSideLanes * 2 + 1;
+constexpr int kCenter = kSideLanes;
+constexpr int kSideCodes = 81;
+constexpr int kWindowCodes = kSideCodes * kSideCodes;
+
+// Scores by level. The first levels follow the contiguous-run rules; threat
+// classes map onto the same scale so broken shapes score like solid ones.
+constexpr int kLevelScores[] = {2, 10, 50, 200, 800, 8000, 20000, 120000, 1000000};
+
+namespace detail {
+
+using Window = std::array<int, kWindowLanes>;
+
+constexpr int kOwn = 1;
+constexpr int kBlocked = 2;
+
+constexpr std::array<std::array<std::uint8_t, 256>, 2> BuildSideCodes() {
+    std::array<std::array<std::uint8_t, 256>, 2> codes{};
+    for (int player = 1; player <= 2; ++player) {
+        for (int bits = 0; bits < 256; ++bits) {
+            int code = 0;
+            int weight = 1;
+            for (int i = 0; i < kSideLanes; ++i) {
+                int lane = (bits >> (i * 2)) & 3;
+                int digit = lane == 0 ? 0 : (lane == player ? kOwn : kBlocked);
+                code += digit * weight;
+                weight *= 3;
+            }
+            codes[player - 1][bits] = static_cast<std::uint8_t>(code);
+        }
+    }
+    return codes;
+}
+
+constexpr Window DecodeWindow(int index) {
+    Window window{};
+    int left = index % kSideCodes;
+    int right = index / kSideCodes;
+    for (int i = 0; i < kSideLanes; ++i) {
+        window[i] = left % 3;
+        window[kCenter + 1 + i] = right % 3;
+        left /= 3;
+        right /= 3;
+    }
+    window[kCenter] = kOwn;
+    return window;
+}
+
+constexpr int CountBits(int mask) {
+    int count = 0;
+    for (; mask != 0; mask &= mask - 1) {
+        ++count;
+    }
+    return count;
+}
+
+// Mask of window lanes that would complete five through the centre; bit
+// kWindowLanes is set when a five already stands.
+constexpr int CompletionMask(int own, int blocked) {
+    int mask = 0;
+    for (int start = 0; start <= kCenter; ++start) {
+        int five = 0x1F << start;
+        if ((blocked & five) != 0) {
+            continue;
+        }
+        int count = CountBits(own & five);
+        if (count == 5) {
+            mask |= 1 << kWindowLanes;
+        } else if (count == 4) {
+            mask |= five & ~own;
+        }
+    }
+    return mask;
+}
+
+constexpr Threat Classify(const Window &window) {
+    int own = 0;
+    int blocked = 0;
+    for (int i = 0; i < kWindowLanes; ++i) {
+        own |= static_cast<int>(window[i] == kOwn) << i;
+        blocked |= static_cast<int>(window[i] == kBlocked) << i;
+    }
+    int completions = CompletionMask(own, blocked);
+    if (completions >> kWindowLanes) {
+        return Threat::Five;
+    }
+    if (completions != 0) {
+        return CountBits(completions) >= 2 ? Threat::OpenFour : Threat::Four;
+    }
+    Threat best = Threat::None;
+    for (int empty = ~(own | blocked) & 0x1FF; empty != 0; empty &= empty - 1) {
+        int count = CountBits(CompletionMask(own | (empty & -empty), blocked));
+        if (count >= 2) {
+            return Threat::OpenThree;
+        }
+        if (count == 1) {
+            best = Threat::Three;
+        }
+    }
+    return best;
+}
+
+constexpr int RunLevel(const Window &window) {
+    int after = 0;
+    while (after < kSideLanes && window[kCenter + 1 + after] == kOwn) {
+        ++after;
+    }
+    int before = 0;
+    while (before < kSideLanes && window[kCenter - 1 - before] == kOwn) {
+        ++before;
+    }
+    int total = after + before + 1;
+    if (total >= 5) {
+        return 8;
+    }
+    int open_ends = static_cast<int>(window[kCenter + after + 1] == 0)
+        + static_cast<int>(window[kCenter - before - 1] == 0);
+    if (total == 4) {
+        return open_ends == 2 ? 7 : (open_ends == 1 ? 6 : 0);
+    }
+    if (total == 3) {
+        return open_ends == 2 ? 5 : (open_ends == 1 ? 4 : 0);
+    }
+    if (total == 2) {
+        return open_ends == 2 ? 3 : (open_ends == 1 ? 2 : 0);
+    }
+    return open_ends == 2 ? 1 : 0;
+}
+
+constexpr int ThreatLevel(Threat threat) {
+    switch (threat) {
+    case Threat::Five:
+        return 8;
+    case Threat::OpenFour:
+        return 7;
+    case Threat::Four:
+        return 6;
+    case Threat::OpenThree:
+        return 5;
+    case Threat::Three:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+constexpr std::array<LinePattern, kWindowCodes> BuildPatternTable() {
+    std::array<LinePattern, kWindowCodes> table{};
+    for (int index = 0; index < kWindowCodes; ++index) {
+        Window window = DecodeWindow(index);
+        Threat threat = Classify(window);
+        int run_level = RunLevel(window);
+        int threat_level = ThreatLevel(threat);
+        table[index].level = static_cast<std::uint8_t>(run_level > threat_level ? run_level : threat_level);
+        table[index].threat = threat;
+    }
+    return table;
+}
+
+} // namespace detail
+
+inline constexpr auto kSideCodeTable = detail::BuildSideCodes();
+inline constexpr auto kPatternTable = detail::BuildPatternTable();
+
+// Pattern of the window centred on lane of a line word, for player (1 or 2).
+inline LinePattern PatternAt(std::uint64_t word, int lane, int player) {
+    const auto &codes = kSideCodeTable[player - 1];
+    int left = codes[(word >> ((lane - kSideLanes) * 2)) & 0xFF];
+    int right = codes[(word >> ((lane + 1) * 2)) & 0xFF];
+    return kPatternTable[left + right * kSideCodes];
+}
+
+} // namespace patterns
+
+#endif
@@ -0,0 +1,156 @@
+#include "mapped_file.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept {
+    swap(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        close();
+        swap(other);
+    }
+    return *this;
+}
+
+void MappedFile::swap(MappedFile &other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(open_, other.open_);
+    std::swap(writable_, other.writable_);
+#ifdef _WIN32
+    std::swap(mapping_, other.mapping_);
+#endif
+}
+
+bool MappedFile::open(const std::string &path) {
+    return map(path, false, 0);
+}
+
+bool MappedFile::openWritable(const std::string &path, std::size_t create_size) {
+    return map(path, true, create_size);
+}
+
+#ifdef _WIN32
+
+bool MappedFile::map(const std::string &path, bool writable, std::size_t create_size) {
+    close();
+    HANDLE file = CreateFileA(path.c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                              writable ? FILE_SHARE_READ | FILE_SHARE_WRITE : FILE_SHARE_READ, nullptr,
+                              writable ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER file_size{};
+    if (!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        return false;
+    }
+    if (writable && file_size.QuadPart == 0 && create_size > 0) {
+        file_size.QuadPart = static_cast<LONGLONG>(create_size);
+        if (!SetFilePointerEx(file, file_size, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) {
+            CloseHandle(file);
+            return false;
+        }
+    }
+    size_ = static_cast<std::size_t>(file_size.QuadPart);
+    if (size_ > 0) {
+        mapping_ = CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+        data_ = mapping_ ? MapViewOfFile(mapping_, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0) : nullptr;
+    }
+    CloseHandle(file);
+    if (size_ > 0 && !data_) {
+        close();
+        return false;
+    }
+    open_ = true;
+    writable_ = writable;
+    return true;
+}
+
+bool MappedFile::flush() {
+    return !writable_ || !data_ || FlushViewOfFile(data_, 0) != 0;
+}
+
+void MappedFile::close() {
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_) {
+        CloseHandle(mapping_);
+    }
+    data_ = nullptr;
+    mapping_ = nullptr;
+    size_ = 0;
+    open_ = false;
+    writable_ = false;
+}
+
+#else
+
+bool MappedFile::map(const std::string &path, bool writable, std::size_t create_size) {
+    close();
+    int fd = writable ? ::open(path.c_str(), O_RDWR | O_CREAT, 0644) : ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info {};
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    if (writable && info.st_size == 0 && create_size > 0) {
+        if (ftruncate(fd, static_cast<off_t>(create_size)) != 0) {
+            ::close(fd);
+            return false;
+        }
+        info.st_size = static_cast<off_t>(create_size);
+    }
+    size_ = static_cast<std::size_t>(info.st_size);
+    if (size_ > 0) {
+        void *mapped = mmap(nullptr, size_, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                            writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+        data_ = mapped == MAP_FAILED ? nullptr : mapped;
+    }
+    ::close(fd);
+    if (size_ > 0 && !data_) {
+        close();
+        return false;
+    }
+    open_ = true;
+    writable_ = writable;
+    return true;
+}
+
+bool MappedFile::flush() {
+    return !writable_ || !data_ || msync(data_, size_, MS_ASYNC) == 0;
+}
+
+void MappedFile::close() {
+    if (data_) {
+        munmap(data_, size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+    writable_ = false;
+}
+
+#endif
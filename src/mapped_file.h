@@ -0,0 +1,48 @@
+#ifndef GOMOKU_MAPPED_FILE_H
+#define GOMOKU_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+// Memory mapping of a whole file, read-only or shared read-write. Pages are
+// loaded on first touch, so opening costs the same however large the file
+// is. Move-only; the mapping is released by close() or the destructor.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    // Replaces any current mapping. An empty file opens with size() 0.
+    bool open(const std::string &path);
+    // Maps the file for reading and writing, creating it when missing and
+    // growing an empty file to create_size first. Stores through
+    // writableData() reach the file; flush() starts writing them back.
+    bool openWritable(const std::string &path, std::size_t create_size);
+    bool flush();
+    void close();
+
+    bool isOpen() const { return open_; }
+    bool isWritable() const { return writable_; }
+    const unsigned char *data() const { return static_cast<const unsigned char *>(data_); }
+    unsigned char *writableData() const { return writable_ ? static_cast<unsigned char *>(data_) : nullptr; }
+    std::size_t size() const { return size_; }
+
+private:
+    void swap(MappedFile &other) noexcept;
+    bool map(const std::string &path, bool writable, std::size_t create_size);
+
+    void *data_ = nullptr;
+    std::size_t size_ = 0;
+    bool open_ = false;
+    bool writable_ = false;
+#ifdef _WIN32
+    void *mapping_ = nullptr;
+#endif
+};
+
+#endif
@@ -0,0 +1,174 @@
+#include "opening_book.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr char kMagic[8] = {'G', 'M', 'K', 'B', 'O', 'O', 'K', '\0'};
+constexpr std::size_t kHeaderSize = 16;
+constexpr std::size_t kRecordSize = 12;
+constexpr int kSymmetries = 8;
+constexpr int kMaxWeight = 0xFFFF;
+
+std::uint64_t ReadLittle(const unsigned char *bytes, int count) {
+    std::uint64_t value = 0;
+    for (int i = count - 1; i >= 0; --i) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+void WriteLittle(unsigned char *bytes, std::uint64_t value, int count) {
+    for (int i = 0; i < count; ++i) {
+        bytes[i] = static_cast<unsigned char>(value >> (i * 8));
+    }
+}
+
+// Symmetry bits: 4 transposes, then 1 mirrors x and 2 mirrors y. The eight
+// combinations are the rotations and reflections of the square.
+std::pair<int, int> Transform(int symmetry, int x, int y) {
+    constexpr int kLast = GomokuGame::kBoardSize - 1;
+    if (symmetry & 4) {
+        std::swap(x, y);
+    }
+    if (symmetry & 1) {
+        x = kLast - x;
+    }
+    if (symmetry & 2) {
+        y = kLast - y;
+    }
+    return {x, y};
+}
+
+std::pair<int, int> InverseTransform(int symmetry, int x, int y) {
+    constexpr int kLast = GomokuGame::kBoardSize - 1;
+    if (symmetry & 1) {
+        x = kLast - x;
+    }
+    if (symmetry & 2) {
+        y = kLast - y;
+    }
+    if (symmetry & 4) {
+        std::swap(x, y);
+    }
+    return {x, y};
+}
+
+int CellOf(const std::pair<int, int> &move) {
+    return move.second * GomokuGame::kBoardSize + move.first;
+}
+
+} // namespace
+
+bool OpeningBook::open(const std::string &path) {
+    close();
+    if (!file_.open(path)) {
+        return false;
+    }
+    const unsigned char *data = file_.data();
+    if (file_.size() < kHeaderSize || std::memcmp(data, kMagic, sizeof(kMagic)) != 0
+        || ReadLittle(data + 8, 4) != kVersion) {
+        close();
+        return false;
+    }
+    std::size_t count = static_cast<std::size_t>(ReadLittle(data + 12, 4));
+    if (file_.size() != kHeaderSize + count * kRecordSize) {
+        close();
+        return false;
+    }
+    count_ = count;
+    return true;
+}
+
+void OpeningBook::close() {
+    file_.close();
+    count_ = 0;
+}
+
+std::uint64_t OpeningBook::canonicalKey(const GomokuGame &game, int &symmetry) {
+    std::uint64_t keys[kSymmetries] = {};
+    for (const Move &move : game.moveHistory()) {
+        for (int s = 0; s < kSymmetries; ++s) {
+            std::pair<int, int> cell = Transform(s, move.x, move.y);
+            keys[s] ^= GomokuGame::zobristKey(cell.first, cell.second, move.player);
+        }
+    }
+    symmetry = 0;
+    for (int s = 1; s < kSymmetries; ++s) {
+        if (keys[s] < keys[symmetry]) {
+            symmetry = s;
+        }
+    }
+    return keys[symmetry];
+}
+
+bool OpeningBook::probe(const GomokuGame &game, std::pair<int, int> &move) const {
+    if (count_ == 0) {
+        return false;
+    }
+    int symmetry = 0;
+    const std::uint64_t key = canonicalKey(game, symmetry);
+    const unsigned char *records = file_.data() + kHeaderSize;
+
+    std::size_t low = 0;
+    std::size_t high = count_;
+    while (low < high) {
+        std::size_t mid = low + (high - low) / 2;
+        if (ReadLittle(records + mid * kRecordSize, 8) < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    int best_weight = -1;
+    for (std::size_t i = low; i < count_; ++i) {
+        const unsigned char *record = records + i * kRecordSize;
+        if (ReadLittle(record, 8) != key) {
+            break;
+        }
+        int cell = static_cast<int>(ReadLittle(record + 8, 2));
+        int weight = static_cast<int>(ReadLittle(record + 10, 2));
+        if (cell >= GomokuGame::kBoardSize * GomokuGame::kBoardSize || weight <= best_weight) {
+            continue;
+        }
+        std::pair<int, int> candidate =
+            InverseTransform(symmetry, cell % GomokuGame::kBoardSize, cell / GomokuGame::kBoardSize);
+        if (game.at(candidate.first, candidate.second) == GomokuGame::kEmpty) {
+            move = candidate;
+            best_weight = weight;
+        }
+    }
+    return best_weight >= 0;
+}
+
+void OpeningBookWriter::add(const GomokuGame &game, std::pair<int, int> move, int weight) {
+    int symmetry = 0;
+    std::uint64_t key = OpeningBook::canonicalKey(game, symmetry);
+    int &total = weights_[{key, CellOf(Transform(symmetry, move.first, move.second))}];
+    total = std::min(total + weight, kMaxWeight);
+}
+
+bool OpeningBookWriter::save(const std::string &path) const {
+    std::vector<unsigned char> bytes(kHeaderSize + weights_.size() * kRecordSize);
+    std::memcpy(bytes.data(), kMagic, sizeof(kMagic));
+    WriteLittle(bytes.data() + 8, OpeningBook::kVersion, 4);
+    WriteLittle(bytes.data() + 12, weights_.size(), 4);
+    unsigned char *record = bytes.data() + kHeaderSize;
+    for (const auto &entry : weights_) {
+        WriteLittle(record, entry.first.first, 8);
+        WriteLittle(record + 8, static_cast<std::uint64_t>(entry.first.second), 2);
+        WriteLittle(record + 10, static_cast<std::uint64_t>(entry.second), 2);
+        record += kRecordSize;
+    }
+
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    return std::fclose(file) == 0 && written;
+}
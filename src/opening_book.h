@@ -0,0 +1,61 @@
+#ifndef GOMOKU_OPENING_BOOK_H
+#define GOMOKU_OPENING_BOOK_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "gomoku.h"
+#include "mapped_file.h"
+
+// Opening book stored as a sorted array of fixed-size records, looked up by
+// binary search directly in a read-only mapping of the file. A position is
+// keyed by the smallest Zobrist hash over the eight rotations and
+// reflections of the board, and its move is stored in that orientation, so
+// one record covers every orientation of the position.
+//
+// File layout, little-endian: a 16-byte header (the magic "GMKBOOK\0", a
+// uint32 version and a uint32 record count) followed by 12-byte records of
+// uint64 key, uint16 move (y * kBoardSize + x) and uint16 weight, sorted by
+// key. A position may have several records, one per move.
+class OpeningBook {
+public:
+    static constexpr std::uint32_t kVersion = 1;
+
+    // Maps the file and checks its header; returns false, leaving the book
+    // closed, when it is missing or malformed.
+    bool open(const std::string &path);
+    void close();
+
+    bool isOpen() const { return file_.isOpen(); }
+    std::size_t size() const { return count_; }
+
+    // Highest-weight book move for the position that is still legal, or
+    // false when the position is not in the book.
+    bool probe(const GomokuGame &game, std::pair<int, int> &move) const;
+
+    // Canonical key of the position, and the symmetry that maps the board
+    // onto the canonical orientation.
+    static std::uint64_t canonicalKey(const GomokuGame &game, int &symmetry);
+
+private:
+    MappedFile file_;
+    std::size_t count_ = 0;
+};
+
+// Collects book moves in memory and writes them as a book file. Adding the
+// same move for the same position again, in any orientation, adds up the
+// weights.
+class OpeningBookWriter {
+public:
+    void add(const GomokuGame &game, std::pair<int, int> move, int weight = 1);
+    bool save(const std::string &path) const;
+
+    std::size_t size() const { return weights_.size(); }
+
+private:
+    std::map<std::pair<std::uint64_t, int>, int> weights_;
+};
+
+#endif
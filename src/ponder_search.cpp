@@ -0,0 +1,99 @@
+#include "ponder_search.h"
+
+#include <algorithm>
+
+namespace {
+
+// Above the search's own depth cap, so a ponder search only ends when it
+// is stopped.
+constexpr int kUnboundedDepth = 1000;
+
+} // namespace
+
+template <int Size>
+bool PonderSearch::ponder(const BasicGomokuGame<Size> &game, int ai_player, int human_player, AiDifficulty difficulty,
+                          const AiSearchOptions &options) {
+    stop();
+    if (difficulty != AiDifficulty::Hard || game.isBoardFull()) {
+        return false;
+    }
+    TranspositionTable &table = options.tt ? *options.tt : DefaultTranspositionTable();
+    std::pair<int, int> reply;
+    if (!PredictedReply(game, human_player, table, reply)) {
+        reply = ComputeAiMove(game, human_player, ai_player, AiDifficulty::Normal);
+    }
+    BasicGomokuGame<Size> next = game;
+    if (!next.placeStone(reply.first, reply.second, human_player)
+        || next.findWinningLine(reply.first, reply.second, human_player) || next.isBoardFull()) {
+        return false;
+    }
+    next.setCurrentPlayer(ai_player);
+
+    // The move's time budget only starts when the reply arrives; until then
+    // the search runs until it is stopped, unless it has a depth or node
+    // limit of its own.
+    AiSearchOptions ponder_options = options;
+    ponder_options.time_budget_ms = 0;
+    if (options.time_budget_ms > 0 && options.max_depth == 0 && options.node_budget == 0) {
+        ponder_options.max_depth = kUnboundedDepth;
+    }
+    search_.start(next, ai_player, human_player, difficulty, ponder_options);
+    pondering_ = true;
+    pondered_hash_ = next.hash();
+    pondered_stones_ = next.stoneCount();
+    predicted_ = reply;
+    return true;
+}
+
+template <int Size>
+bool PonderSearch::beginMove(const BasicGomokuGame<Size> &game, int ai_player, int human_player,
+                             AiDifficulty difficulty, const AiSearchOptions &options) {
+    bool hit = pondering_ && game.hash() == pondered_hash_ && game.stoneCount() == pondered_stones_;
+    pondering_ = false;
+    has_deadline_ = options.time_budget_ms > 0;
+    deadline_ = Clock::now() + std::chrono::milliseconds(options.time_budget_ms);
+    if (!hit) {
+        search_.start(game, ai_player, human_player, difficulty, options);
+    }
+    return hit;
+}
+
+bool PonderSearch::done() const {
+    return search_.done() || (has_deadline_ && Clock::now() >= deadline_);
+}
+
+AiSearchResult PonderSearch::finish() {
+    has_deadline_ = false;
+    return search_.stop();
+}
+
+template <int Size>
+AiSearchResult PonderSearch::respond(const BasicGomokuGame<Size> &game, int ai_player, int human_player,
+                                     AiDifficulty difficulty, const AiSearchOptions &options) {
+    beginMove(game, ai_player, human_player, difficulty, options);
+    while (!done()) {
+        int wait_ms = -1;
+        if (has_deadline_) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline_ - Clock::now());
+            wait_ms = static_cast<int>(std::max<std::chrono::milliseconds::rep>(remaining.count(), 1));
+        }
+        search_.wait(wait_ms);
+    }
+    return finish();
+}
+
+void PonderSearch::stop() {
+    pondering_ = false;
+    has_deadline_ = false;
+    search_.stop();
+}
+
+#define GOMOKU_INSTANTIATE(N)                                                                              \
+    template bool PonderSearch::ponder(const BasicGomokuGame<N> &, int, int, AiDifficulty,                  \
+                                       const AiSearchOptions &);                                            \
+    template bool PonderSearch::beginMove(const BasicGomokuGame<N> &, int, int, AiDifficulty,               \
+                                          const AiSearchOptions &);                                         \
+    template AiSearchResult PonderSearch::respond(const BasicGomokuGame<N> &, int, int, AiDifficulty,       \
+                                                  const AiSearchOptions &);
+GOMOKU_FOR_EACH_BOARD_SIZE(GOMOKU_INSTANTIATE)
+#undef GOMOKU_INSTANTIATE
@@ -0,0 +1,65 @@
+#ifndef GOMOKU_PONDER_SEARCH_H
+#define GOMOKU_PONDER_SEARCH_H
+
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+#include "async_search.h"
+#include "gomoku.h"
+#include "gomoku_ai.h"
+
+// Searches on the opponent's time. After the engine has moved, ponder()
+// predicts the reply and searches the position after it in the
+// background. When the reply arrives, beginMove() either keeps that search
+// or cancels it and searches the real position. On a hit the search goes on
+// for the move's time budget, counted from the reply, on top of the time it
+// already had; a depth or node limit covers the ponder search as a whole. A
+// miss still starts from the table the ponder search warmed up. The caller
+// polls done() and collects the move with finish(), or uses respond().
+//
+// Only Hard searches ponder. The options' table must outlive the object.
+// Options with no time budget, depth or node limit stop the ponder search,
+// like the move, at the search's default depth, so there is little to gain;
+// give Hard a time budget to ponder for as long as the opponent thinks.
+class PonderSearch {
+public:
+    // Starts pondering on game, the position right after the engine's move
+    // with the opponent to move. Returns false, and does nothing, when
+    // there is nothing to ponder.
+    template <int Size>
+    bool ponder(const BasicGomokuGame<Size> &game, int ai_player, int human_player, AiDifficulty difficulty,
+                const AiSearchOptions &options);
+
+    // Starts the engine's move on game, the position after the opponent's
+    // reply. Returns whether the ponder search was searching it.
+    template <int Size>
+    bool beginMove(const BasicGomokuGame<Size> &game, int ai_player, int human_player, AiDifficulty difficulty,
+                   const AiSearchOptions &options);
+    // The move started by beginMove is ready to collect.
+    bool done() const;
+    AiSearchResult finish();
+    // beginMove, then wait for done() and finish().
+    template <int Size>
+    AiSearchResult respond(const BasicGomokuGame<Size> &game, int ai_player, int human_player, AiDifficulty difficulty,
+                           const AiSearchOptions &options);
+
+    // Cancels whatever is running.
+    void stop();
+
+    bool pondering() const { return pondering_; }
+    std::pair<int, int> predictedReply() const { return predicted_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    AsyncSearch search_;
+    bool pondering_ = false;
+    std::uint64_t pondered_hash_ = 0;
+    int pondered_stones_ = 0;
+    std::pair<int, int> predicted_{-1, -1};
+    bool has_deadline_ = false;
+    Clock::time_point deadline_{};
+};
+
+#endif
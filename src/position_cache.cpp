@@ -0,0 +1,187 @@
+#include "position_cache.h"
+
+#include <atomic>
+#include <cstring>
+
+namespace {
+
+constexpr char kMagic[8] = {'G', 'M', 'K', 'C', 'A', 'C', 'H', 'E'};
+constexpr std::size_t kHeaderSize = 64;
+constexpr std::size_t kSlotsPerBucket = 4;
+constexpr std::size_t kBucketSize = kSlotsPerBucket * 2 * sizeof(std::uint64_t);
+
+using Word = std::atomic<std::uint64_t>;
+static_assert(sizeof(Word) == sizeof(std::uint64_t) && Word::is_always_lock_free,
+              "cache slots are read in place as atomic words");
+
+// Packed slot data as in the transposition table, without the generation:
+// score in bits 0-31, move in 32-47, depth in 48-55 and bound in 56-57.
+std::uint64_t Pack(const TranspositionEntry &entry) {
+    return static_cast<std::uint64_t>(static_cast<std::uint32_t>(entry.score))
+         | static_cast<std::uint64_t>(static_cast<std::uint16_t>(entry.move)) << 32
+         | static_cast<std::uint64_t>(static_cast<std::uint8_t>(entry.depth)) << 48
+         | static_cast<std::uint64_t>(entry.bound) << 56;
+}
+
+TranspositionEntry Unpack(std::uint64_t data) {
+    TranspositionEntry entry;
+    entry.score = static_cast<std::int32_t>(static_cast<std::uint32_t>(data));
+    entry.move = static_cast<std::int16_t>(static_cast<std::uint16_t>(data >> 32));
+    entry.depth = static_cast<std::int8_t>(static_cast<std::uint8_t>(data >> 48));
+    entry.bound = static_cast<BoundType>((data >> 56) & 3);
+    return entry;
+}
+
+// Changes whenever the board size or the Zobrist keys do, or when the file
+// was written on a machine with the other byte order.
+template <int Size>
+std::uint64_t KeyFingerprint() {
+    using Game = BasicGomokuGame<Size>;
+    std::uint64_t fingerprint = Size;
+    for (int y = 0; y < Size; ++y) {
+        for (int x = 0; x < Size; ++x) {
+            fingerprint = fingerprint * 31 + Game::zobristKey(x, y, Game::kBlack);
+            fingerprint = fingerprint * 31 + Game::zobristKey(x, y, Game::kWhite);
+        }
+    }
+    return fingerprint ^ Game::emptyHash();
+}
+
+std::uint64_t Mix(std::uint64_t hash, std::uint64_t value) {
+    hash ^= value + 0x9E3779B97F4A7C15ULL + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+} // namespace
+
+struct PositionCache::Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t board_size;
+    std::uint64_t bucket_count;
+    std::uint64_t fingerprint;
+    std::uint64_t checksum;
+    std::uint8_t reserved[24];
+
+    std::uint64_t computeChecksum() const {
+        std::uint64_t hash = 0;
+        for (char c : magic) {
+            hash = Mix(hash, static_cast<std::uint8_t>(c));
+        }
+        hash = Mix(hash, version);
+        hash = Mix(hash, board_size);
+        hash = Mix(hash, bucket_count);
+        return Mix(hash, fingerprint);
+    }
+};
+
+bool PositionCache::open(const std::string &path, std::size_t megabytes, int board_size) {
+    static_assert(sizeof(Header) == kHeaderSize, "cache header layout");
+    close();
+    if (!IsSupportedBoardSize(board_size)) {
+        return false;
+    }
+    std::size_t bucket_count = 1;
+    while (bucket_count * 2 * kBucketSize <= (megabytes == 0 ? 1 : megabytes) * 1024 * 1024) {
+        bucket_count *= 2;
+    }
+    if (!file_.openWritable(path, kHeaderSize + bucket_count * kBucketSize)) {
+        return false;
+    }
+    unsigned char *data = file_.writableData();
+    if (file_.size() < kHeaderSize) {
+        file_.close();
+        return false;
+    }
+
+    Header header;
+    std::memcpy(&header, data, kHeaderSize);
+    const std::uint64_t fingerprint =
+        WithBoardSize(board_size, [](auto size) { return KeyFingerprint<decltype(size)::value>(); });
+    bool fresh = true;
+    for (std::size_t i = 0; i < kHeaderSize && fresh; ++i) {
+        fresh = data[i] == 0;
+    }
+    if (fresh && file_.size() == kHeaderSize + bucket_count * kBucketSize) {
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.board_size = static_cast<std::uint32_t>(board_size);
+        header.bucket_count = bucket_count;
+        header.fingerprint = fingerprint;
+        header.checksum = header.computeChecksum();
+        std::memcpy(data, &header, kHeaderSize);
+    } else if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion
+               || header.board_size != static_cast<std::uint32_t>(board_size) || header.fingerprint != fingerprint
+               || header.checksum != header.computeChecksum()
+               || file_.size() != kHeaderSize + header.bucket_count * kBucketSize) {
+        file_.close();
+        return false;
+    }
+    bucket_count_ = static_cast<std::size_t>(header.bucket_count);
+    board_size_ = board_size;
+    return true;
+}
+
+void PositionCache::close() {
+    std::lock_guard<std::mutex> lock(store_mutex_);
+    file_.flush();
+    file_.close();
+    bucket_count_ = 0;
+    board_size_ = 0;
+}
+
+bool PositionCache::probe(std::uint64_t key, TranspositionEntry &entry) const {
+    if (bucket_count_ == 0) {
+        return false;
+    }
+    const auto *slots =
+        reinterpret_cast<const Word *>(file_.data() + kHeaderSize + (key & (bucket_count_ - 1)) * kBucketSize);
+    for (std::size_t i = 0; i < kSlotsPerBucket; ++i) {
+        std::uint64_t check = slots[i * 2].load(std::memory_order_relaxed);
+        std::uint64_t data = slots[i * 2 + 1].load(std::memory_order_relaxed);
+        if ((check ^ data) != key || ((data >> 56) & 3) == 0) {
+            continue;
+        }
+        entry = Unpack(data);
+        return true;
+    }
+    return false;
+}
+
+void PositionCache::store(const std::vector<CachedPosition> &batch) {
+    std::lock_guard<std::mutex> lock(store_mutex_);
+    if (bucket_count_ == 0 || batch.empty()) {
+        return;
+    }
+    for (const CachedPosition &position : batch) {
+        auto *slots = reinterpret_cast<Word *>(file_.writableData() + kHeaderSize
+                                               + (position.key & (bucket_count_ - 1)) * kBucketSize);
+        Word *victim = nullptr;
+        int victim_depth = 0;
+        bool same_key = false;
+        for (std::size_t i = 0; i < kSlotsPerBucket; ++i) {
+            std::uint64_t check = slots[i * 2].load(std::memory_order_relaxed);
+            std::uint64_t data = slots[i * 2 + 1].load(std::memory_order_relaxed);
+            bool empty = ((data >> 56) & 3) == 0;
+            if (!empty && (check ^ data) == position.key) {
+                victim = &slots[i * 2];
+                victim_depth = Unpack(data).depth;
+                same_key = true;
+                break;
+            }
+            int depth = empty ? -1 : Unpack(data).depth;
+            if (!victim || depth < victim_depth) {
+                victim = &slots[i * 2];
+                victim_depth = depth;
+            }
+        }
+        if (same_key && position.entry.depth < victim_depth) {
+            continue;
+        }
+        std::uint64_t data = Pack(position.entry);
+        victim[1].store(data, std::memory_order_relaxed);
+        victim[0].store(position.key ^ data, std::memory_order_relaxed);
+    }
+    file_.flush();
+}
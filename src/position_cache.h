@@ -0,0 +1,67 @@
+#ifndef GOMOKU_POSITION_CACHE_H
+#define GOMOKU_POSITION_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "gomoku.h"
+#include "mapped_file.h"
+#include "transposition_table.h"
+
+struct CachedPosition {
+    std::uint64_t key = 0;
+    TranspositionEntry entry;
+};
+
+// Search results kept in a memory-mapped file so that they outlive the
+// process. The file is a 64-byte header followed by buckets laid out like
+// the transposition table's: four 16-byte slots, each the packed entry and
+// the key xor-ed with it, in native byte order. A torn or damaged slot
+// fails that check and reads as a miss.
+//
+// The header carries a magic, kVersion, the board size, a fingerprint of
+// the Zobrist keys and a checksum. A file whose header does not match is
+// treated as foreign: open() fails and the file is left untouched. Bump
+// kVersion whenever the meaning of a stored score changes.
+//
+// Probes are lock-free and may run on any number of threads. Writes are
+// applied in batches by store(), which is serialized.
+class PositionCache {
+public:
+    static constexpr std::uint32_t kVersion = 2;
+    static constexpr std::size_t kDefaultMegabytes = 32;
+
+    PositionCache() = default;
+    PositionCache(const PositionCache &) = delete;
+    PositionCache &operator=(const PositionCache &) = delete;
+
+    // Opens path, or creates it with room for about megabytes of entries
+    // when it is missing or empty. An existing file keeps its own size.
+    // board_size must be supported; a file written for another size is
+    // foreign.
+    bool open(const std::string &path, std::size_t megabytes = kDefaultMegabytes,
+              int board_size = GomokuGame::kBoardSize);
+    void close();
+
+    bool isOpen() const { return bucket_count_ != 0; }
+    int boardSize() const { return board_size_; }
+    std::size_t sizeMegabytes() const { return file_.size() >> 20; }
+
+    bool probe(std::uint64_t key, TranspositionEntry &entry) const;
+    // Writes the batch into the mapping and schedules it for write-back. A
+    // result never replaces a deeper one for the same position.
+    void store(const std::vector<CachedPosition> &batch);
+
+private:
+    struct Header;
+
+    MappedFile file_;
+    std::size_t bucket_count_ = 0;
+    int board_size_ = 0;
+    std::mutex store_mutex_;
+};
+
+#endif
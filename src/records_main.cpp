@@ -0,0 +1,138 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "game_record.h"
+
+// Moves games in and out of game-record archives.
+namespace {
+
+void PrintUsage(const char *program) {
+    std::fprintf(stderr,
+                 "usage: %s import ARCHIVE FILE.psq...   append Piskvork games to ARCHIVE\n"
+                 "       %s export ARCHIVE DIR           write each game to DIR/game-N.psq\n"
+                 "       %s list ARCHIVE                 print one game per line\n"
+                 "Listed games end with their moves in the engine's \"x,y x,y ...\" form.\n",
+                 program, program, program);
+}
+
+const char *ResultName(GameResult result) {
+    switch (result) {
+        case GameResult::BlackWin:
+            return "black";
+        case GameResult::WhiteWin:
+            return "white";
+        case GameResult::Draw:
+            return "draw";
+        default:
+            return "unknown";
+    }
+}
+
+bool ReadFile(const std::string &path, std::string &text) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    text = contents.str();
+    return true;
+}
+
+int Import(const std::string &archive, char **paths, int count) {
+    GameRecordWriter writer;
+    if (!writer.open(archive)) {
+        std::fprintf(stderr, "cannot open %s for appending, or it is not a game archive\n", archive.c_str());
+        return 1;
+    }
+    int imported = 0;
+    for (int i = 0; i < count; ++i) {
+        std::string text;
+        GameRecord record;
+        if (!ReadFile(paths[i], text) || !ParsePsq(text, record)) {
+            std::fprintf(stderr, "skipping %s: not a readable .psq game\n", paths[i]);
+            continue;
+        }
+        if (!writer.append(record)) {
+            std::fprintf(stderr, "cannot write to %s\n", archive.c_str());
+            return 1;
+        }
+        ++imported;
+    }
+    if (!writer.close()) {
+        std::fprintf(stderr, "cannot write to %s\n", archive.c_str());
+        return 1;
+    }
+    std::printf("imported %d of %d games\n", imported, count);
+    return imported == count ? 0 : 1;
+}
+
+// Reports a damaged archive after the games before the damage are done.
+int FinishReading(const GameRecordReader &reader, const std::string &archive) {
+    if (reader.damaged()) {
+        std::fprintf(stderr, "%s is damaged after the last game shown\n", archive.c_str());
+        return 1;
+    }
+    return 0;
+}
+
+int Export(const std::string &archive, const std::string &directory) {
+    GameRecordReader reader;
+    if (!reader.open(archive)) {
+        std::fprintf(stderr, "cannot open game archive %s\n", archive.c_str());
+        return 1;
+    }
+    GameRecordView view;
+    int index = 0;
+    while (reader.next(view)) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "/game-%06d.psq", ++index);
+        std::string path = directory + name;
+        std::ofstream file(path, std::ios::binary);
+        if (!(file << FormatPsq(view.toRecord()))) {
+            std::fprintf(stderr, "cannot write %s\n", path.c_str());
+            return 1;
+        }
+    }
+    std::printf("exported %d games\n", index);
+    return FinishReading(reader, archive);
+}
+
+int List(const std::string &archive) {
+    GameRecordReader reader;
+    if (!reader.open(archive)) {
+        std::fprintf(stderr, "cannot open game archive %s\n", archive.c_str());
+        return 1;
+    }
+    GameRecordView view;
+    int index = 0;
+    while (reader.next(view)) {
+        std::printf("game %d size %d result %s moves %d", ++index, view.boardSize(), ResultName(view.result()),
+                    view.moveCount());
+        for (int i = 0; i < view.moveCount(); ++i) {
+            std::pair<int, int> move = view.move(i);
+            std::printf("%s%d,%d", i == 0 ? " : " : " ", move.first, move.second);
+        }
+        std::printf("\n");
+    }
+    return FinishReading(reader, archive);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string command = argc > 1 ? argv[1] : "";
+    if (command == "import" && argc >= 4) {
+        return Import(argv[2], argv + 3, argc - 3);
+    }
+    if (command == "export" && argc == 4) {
+        return Export(argv[2], argv[3]);
+    }
+    if (command == "list" && argc == 3) {
+        return List(argv[2]);
+    }
+    PrintUsage(argv[0]);
+    return 2;
+}
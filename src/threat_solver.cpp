@@ -0,0 +1,338 @@
+#include "threat_solver.h"
+
+#include "eval_kernel.h"
+#include "line_patterns.h"
+
+#include <array>
+
+namespace {
+
+constexpr std::uint64_t kVctKey = 0x6A09E667F3BCC908ULL;
+constexpr std::uint64_t kWhiteAttackerKey = 0xBB67AE8584CAA73BULL;
+constexpr std::uint64_t kFiveWindow = 0x155ULL;
+
+struct LineMasks {
+    std::uint64_t owned = 0;
+    std::uint64_t empty = 0;
+    int lane = 0;
+};
+
+template <int Size>
+LineMasks MasksAt(const BasicGomokuGame<Size> &game, int dir, int x, int y, int player) {
+    std::uint64_t word = game.lineWord(dir, x, y);
+    std::uint64_t occupied = (word | (word >> 1)) & bitboard::kLaneLowBits;
+    return LineMasks{bitboard::OwnedLanes(word, player), ~occupied & bitboard::kLaneLowBits,
+                     game.lineLane(dir, x, y)};
+}
+
+// Empty lanes that complete five inside a window covering both first and last.
+std::uint64_t CompletionLanes(std::uint64_t owned, std::uint64_t empty, int first, int last) {
+    std::uint64_t result = 0;
+    for (int start = last - 4; start <= first; ++start) {
+        std::uint64_t window = kFiveWindow << (start * 2);
+        if (bitboard::PopCount(owned & window) == 4 && bitboard::PopCount(empty & window) == 1) {
+            result |= empty & window;
+        }
+    }
+    return result;
+}
+
+template <int Size>
+int CellOf(int x, int y) {
+    return y * Size + x;
+}
+
+template <int Size>
+int LaneCell(int dir, int x, int y, int lane_from, int lane_to) {
+    int step = lane_to - lane_from;
+    return CellOf<Size>(x + bitboard::kDirections[dir][0] * step, y + bitboard::kDirections[dir][1] * step);
+}
+
+template <int Size>
+patterns::Threat ThreatAt(const BasicGomokuGame<Size> &game, int dir, int x, int y, int player) {
+    return patterns::PatternAt(game.lineWord(dir, x, y), game.lineLane(dir, x, y), player).threat;
+}
+
+// Whether playing the empty cell would give player a four.
+template <int Size>
+bool MakesFour(const BasicGomokuGame<Size> &game, int x, int y, int player) {
+    for (int dir = 0; dir < 4; ++dir) {
+        patterns::Threat threat = ThreatAt(game, dir, x, y, player);
+        if (threat == patterns::Threat::Four || threat == patterns::Threat::OpenFour) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Cells that complete five through the stone just placed at (x, y).
+template <int Size>
+int CompletionCells(const BasicGomokuGame<Size> &game, int x, int y, int player, int *cells) {
+    int count = 0;
+    for (int dir = 0; dir < 4; ++dir) {
+        LineMasks line = MasksAt(game, dir, x, y, player);
+        std::uint64_t lanes = CompletionLanes(line.owned, line.empty, line.lane, line.lane);
+        while (lanes != 0) {
+            int lane = bitboard::CountTrailingZeros(lanes) / 2;
+            lanes &= lanes - 1;
+            cells[count++] = LaneCell<Size>(dir, x, y, line.lane, lane);
+        }
+    }
+    return count;
+}
+
+// Shape bits for a candidate cell: the low four bits are the directions in
+// which the attacker would make an open three.
+constexpr int kOpenThreeDirs = 0x0F;
+constexpr int kAttackerFour = 0x10;
+constexpr int kAttackerFive = 0x20;
+constexpr int kDefenderFive = 0x40;
+
+// Shape bits of an empty cell from its threat classes.
+int CellShape(const CellThreats &threats, int attacker) {
+    const auto &own = attacker == GomokuGame::kBlack ? threats.black : threats.white;
+    const auto &other = attacker == GomokuGame::kBlack ? threats.white : threats.black;
+    int shape = 0;
+    for (int dir = 0; dir < 4; ++dir) {
+        switch (own[dir]) {
+            case patterns::Threat::Five:
+                shape |= kAttackerFive;
+                break;
+            case patterns::Threat::Four:
+            case patterns::Threat::OpenFour:
+                shape |= kAttackerFour;
+                break;
+            case patterns::Threat::OpenThree:
+                shape |= 1 << dir;
+                break;
+            default:
+                break;
+        }
+        if (other[dir] == patterns::Threat::Five) {
+            shape |= kDefenderFive;
+        }
+    }
+    return shape;
+}
+
+template <int Size>
+int CollectCandidates(const BasicGomokuGame<Size> &game, int *cells) {
+    int count = 0;
+    game.forEachCandidate([&](int x, int y) {
+        cells[count++] = CellOf<Size>(x, y);
+    });
+    return count;
+}
+
+} // namespace
+
+ThreatSolver::ThreatSolver(int table_bits)
+    : table_(static_cast<std::size_t>(1) << table_bits) {}
+
+void ThreatSolver::clear() {
+    table_.assign(table_.size(), Entry{});
+}
+
+std::size_t ThreatSolver::memoryBytes() const {
+    return sizeof(ThreatSolver) + table_.size() * sizeof(Entry);
+}
+
+std::size_t ThreatSolver::memoryBytes(int table_bits) {
+    return sizeof(ThreatSolver) + (static_cast<std::size_t>(1) << table_bits) * sizeof(Entry);
+}
+
+template <int Size>
+ThreatSearchResult ThreatSolver::solveVcf(BasicGomokuGame<Size> &game, int attacker, std::uint64_t node_limit,
+                                        int max_depth) {
+    ThreatSearchResult result;
+    nodes_ = 0;
+    node_limit_ = node_limit;
+    aborted_ = false;
+    int move = -1;
+    result.win = search(game, attacker, max_depth, false, move);
+    if (result.win) {
+        result.move = {move % Size, move / Size};
+    }
+    result.nodes = nodes_;
+    result.aborted = aborted_;
+    return result;
+}
+
+template <int Size>
+ThreatSearchResult ThreatSolver::solveVct(BasicGomokuGame<Size> &game, int attacker, std::uint64_t node_limit,
+                                        int max_depth) {
+    ThreatSearchResult result;
+    nodes_ = 0;
+    node_limit_ = node_limit;
+    aborted_ = false;
+    int move = -1;
+    result.win = search(game, attacker, max_depth, true, move);
+    if (result.win) {
+        result.move = {move % Size, move / Size};
+    }
+    result.nodes = nodes_;
+    result.aborted = aborted_;
+    return result;
+}
+
+bool ThreatSolver::enterNode() {
+    ++nodes_;
+    if (node_limit_ != 0 && nodes_ > node_limit_) {
+        aborted_ = true;
+    }
+    return aborted_;
+}
+
+template <int Size>
+bool ThreatSolver::search(BasicGomokuGame<Size> &game, int attacker, int depth, bool allow_threes, int &move) {
+    if (enterNode()) {
+        return false;
+    }
+    const int defender = GomokuGame::kBlack + GomokuGame::kWhite - attacker;
+    std::array<int, Size * Size> cells;
+    std::array<std::uint8_t, Size * Size> shapes;
+    std::array<CellThreats, Size * Size> threats;
+    const int cell_count = CollectCandidates(game, cells.data());
+    ClassifyCells(game, cells.data(), cell_count, threats.data());
+
+    for (int i = 0; i < cell_count; ++i) {
+        int shape = CellShape(threats[i], attacker);
+        if (shape & kAttackerFive) {
+            move = cells[i];
+            return true;
+        }
+        shapes[i] = static_cast<std::uint8_t>(shape);
+    }
+    if (depth <= 0) {
+        return false;
+    }
+
+    std::uint64_t key = game.hash();
+    if (allow_threes) {
+        key ^= kVctKey;
+    }
+    if (attacker == GomokuGame::kWhite) {
+        key ^= kWhiteAttackerKey;
+    }
+    Entry &entry = entryFor(key);
+    if (entry.key == key) {
+        if (entry.outcome == Outcome::Win) {
+            move = entry.move;
+            return true;
+        }
+        if (entry.outcome == Outcome::Fail && entry.depth >= depth) {
+            return false;
+        }
+    }
+
+    int forced = -1;
+    for (int i = 0; i < cell_count; ++i) {
+        if (shapes[i] & kDefenderFive) {
+            if (forced >= 0) {
+                entry = Entry{key, static_cast<std::int8_t>(depth), Outcome::Fail, -1};
+                return false;
+            }
+            forced = cells[i];
+        }
+    }
+
+    std::array<int, Size * Size> defences;
+    std::array<bool, Size * Size> listed;
+    for (int pass = 0; pass < (allow_threes ? 2 : 1); ++pass) {
+        for (int i = 0; i < cell_count; ++i) {
+            if (forced >= 0 && cells[i] != forced) {
+                continue;
+            }
+            int x = cells[i] % Size;
+            int y = cells[i] / Size;
+            bool four = (shapes[i] & kAttackerFour) != 0;
+            int three_dirs = four ? 0 : shapes[i] & kOpenThreeDirs;
+            if (pass == 0 ? !four : three_dirs == 0) {
+                continue;
+            }
+
+            game.placeStone(x, y, attacker);
+            int defence_count = 0;
+            listed.fill(false);
+            auto add_defence = [&](int cell) {
+                if (!listed[cell]) {
+                    listed[cell] = true;
+                    defences[defence_count++] = cell;
+                }
+            };
+
+            int completions = 0;
+            if (four) {
+                std::array<int, 8> completion_cells;
+                completions = CompletionCells(game, x, y, attacker, completion_cells.data());
+                for (int c = 0; c < completions; ++c) {
+                    add_defence(completion_cells[c]);
+                }
+            } else {
+                for (int dir = 0; dir < 4; ++dir) {
+                    if ((three_dirs & (1 << dir)) == 0) {
+                        continue;
+                    }
+                    for (int step = -5; step <= 5; ++step) {
+                        int nx = x + bitboard::kDirections[dir][0] * step;
+                        int ny = y + bitboard::kDirections[dir][1] * step;
+                        if (nx >= 0 && nx < Size && ny >= 0 && ny < Size
+                            && game.at(nx, ny) == GomokuGame::kEmpty) {
+                            add_defence(CellOf<Size>(nx, ny));
+                        }
+                    }
+                }
+            }
+
+            // A single completion point leaves the defender no choice; any
+            // other threat can be met with a counter-four.
+            if (completions != 1) {
+                std::array<int, Size * Size> replies;
+                int reply_count = CollectCandidates(game, replies.data());
+                for (int r = 0; r < reply_count; ++r) {
+                    if (MakesFour(game, replies[r] % Size, replies[r] / Size,
+                                  defender)) {
+                        add_defence(replies[r]);
+                    }
+                }
+            }
+
+            bool win = defendedByAll(game, attacker, depth, allow_threes, defences.data(), defence_count);
+            game.undoLastMove();
+            if (win) {
+                move = cells[i];
+                entry = Entry{key, static_cast<std::int8_t>(depth), Outcome::Win, static_cast<std::int16_t>(move)};
+                return true;
+            }
+            if (aborted_) {
+                return false;
+            }
+        }
+    }
+
+    entry = Entry{key, static_cast<std::int8_t>(depth), Outcome::Fail, -1};
+    return false;
+}
+
+// True if the attacker still wins after every listed defender reply.
+template <int Size>
+bool ThreatSolver::defendedByAll(BasicGomokuGame<Size> &game, int attacker, int depth, bool allow_threes,
+                                 const int *defences, int defence_count) {
+    const int defender = GomokuGame::kBlack + GomokuGame::kWhite - attacker;
+    for (int i = 0; i < defence_count; ++i) {
+        game.placeStone(defences[i] % Size, defences[i] / Size, defender);
+        int reply = -1;
+        bool win = search(game, attacker, depth - 1, allow_threes, reply);
+        game.undoLastMove();
+        if (!win) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#define GOMOKU_INSTANTIATE(N)                                                                         \
+    template ThreatSearchResult ThreatSolver::solveVcf(BasicGomokuGame<N> &, int, std::uint64_t, int);  \
+    template ThreatSearchResult ThreatSolver::solveVct(BasicGomokuGame<N> &, int, std::uint64_t, int);
+GOMOKU_FOR_EACH_BOARD_SIZE(GOMOKU_INSTANTIATE)
+#undef GOMOKU_INSTANTIATE
@@ -0,0 +1,78 @@
+#ifndef GOMOKU_THREAT_SOLVER_H
+#define GOMOKU_THREAT_SOLVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "gomoku.h"
+
+struct ThreatSearchResult {
+    bool win = false;
+    std::pair<int, int> move{-1, -1};
+    std::uint64_t nodes = 0;
+    bool aborted = false;
+};
+
+// Threat-space search for forced wins. VCF (victory by continuous fours)
+// only plays fours, which leave the defender a single reply. VCT also plays
+// open threes; the defender is then allowed every empty cell within five
+// lanes of the three on its line plus any move that makes a four of their
+// own. Both respect the defender's existing fours: the attacker has to block
+// them, and only continues if the block is itself a threat.
+//
+// The game is modified during the search and restored before returning. The
+// solver keeps a small table of proven results between calls; clear() drops
+// it when the caller moves on to an unrelated position. The search keeps
+// its solvers in the transposition table, so they last as long as it does.
+// One solver serves every board size: hashes start from the size's
+// emptyHash(), so positions on different sizes do not share keys.
+class ThreatSolver {
+public:
+    static constexpr int kDefaultTableBits = 14;
+    static constexpr int kMaxVcfDepth = 20;
+    static constexpr int kMaxVctDepth = 8;
+
+    explicit ThreatSolver(int table_bits = kDefaultTableBits);
+
+    template <int Size>
+    ThreatSearchResult solveVcf(BasicGomokuGame<Size> &game, int attacker, std::uint64_t node_limit,
+                                int max_depth = kMaxVcfDepth);
+    template <int Size>
+    ThreatSearchResult solveVct(BasicGomokuGame<Size> &game, int attacker, std::uint64_t node_limit,
+                                int max_depth = kMaxVctDepth);
+    void clear();
+    std::size_t memoryBytes() const;
+    // The memory of a solver built with table_bits.
+    static std::size_t memoryBytes(int table_bits);
+
+private:
+    enum class Outcome : std::uint8_t {
+        Unknown,
+        Win,
+        Fail
+    };
+
+    struct Entry {
+        std::uint64_t key = 0;
+        std::int8_t depth = -1;
+        Outcome outcome = Outcome::Unknown;
+        std::int16_t move = -1;
+    };
+
+    template <int Size>
+    bool search(BasicGomokuGame<Size> &game, int attacker, int depth, bool allow_threes, int &move);
+    template <int Size>
+    bool defendedByAll(BasicGomokuGame<Size> &game, int attacker, int depth, bool allow_threes, const int *defences,
+                       int defence_count);
+    bool enterNode();
+    Entry &entryFor(std::uint64_t key) { return table_[key & (table_.size() - 1)]; }
+
+    std::vector<Entry> table_;
+    std::uint64_t nodes_ = 0;
+    std::uint64_t node_limit_ = 0;
+    bool aborted_ = false;
+};
+
+#endif
@@ -0,0 +1,233 @@
+#include "transposition_table.h"
+
+#include "threat_solver.h"
+
+namespace {
+
+// Packed slot data: score in bits 0-31, move in 32-47, depth in 48-55,
+// generation in 58-63 and bound in 56-57.
+std::uint64_t Pack(int score, int move, int depth, BoundType bound, std::uint8_t generation) {
+    return static_cast<std::uint64_t>(static_cast<std::uint32_t>(score))
+         | static_cast<std::uint64_t>(static_cast<std::uint16_t>(move)) << 32
+         | static_cast<std::uint64_t>(static_cast<std::uint8_t>(depth)) << 48
+         | static_cast<std::uint64_t>(bound) << 56
+         | static_cast<std::uint64_t>(generation) << 58;
+}
+
+int ScoreOf(std::uint64_t data) {
+    return static_cast<std::int32_t>(static_cast<std::uint32_t>(data));
+}
+
+int MoveOf(std::uint64_t data) {
+    return static_cast<std::int16_t>(static_cast<std::uint16_t>(data >> 32));
+}
+
+int DepthOf(std::uint64_t data) {
+    return static_cast<std::int8_t>(static_cast<std::uint8_t>(data >> 48));
+}
+
+BoundType BoundOf(std::uint64_t data) {
+    return static_cast<BoundType>((data >> 56) & 3);
+}
+
+std::uint8_t GenerationOf(std::uint64_t data) {
+    return static_cast<std::uint8_t>(data >> 58);
+}
+
+std::atomic<unsigned> next_shard{0};
+
+} // namespace
+
+// The solvers of one search, one per thread. A set cleared while leased is
+// cleared when it is handed back instead.
+struct ThreatSolverSet {
+    std::vector<std::unique_ptr<ThreatSolver>> solvers;
+    bool leased = false;
+    bool stale = false;
+};
+
+TranspositionTable::TranspositionTable(std::size_t megabytes) {
+    resize(megabytes);
+}
+
+TranspositionTable::~TranspositionTable() = default;
+
+void TranspositionTable::resize(std::size_t megabytes) {
+    if (megabytes == 0) {
+        megabytes = 1;
+    }
+    std::size_t count = 1;
+    while (count * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024) {
+        count *= 2;
+    }
+    buckets_.reset(new Bucket[count]);
+    bucket_count_ = count;
+    megabytes_ = megabytes;
+    generation_.store(0, std::memory_order_relaxed);
+    resetStats();
+}
+
+void TranspositionTable::clear() {
+    for (std::size_t i = 0; i < bucket_count_; ++i) {
+        for (Slot &slot : buckets_[i].slots) {
+            slot.check.store(0, std::memory_order_relaxed);
+            slot.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    generation_.store(0, std::memory_order_relaxed);
+    resetStats();
+    std::lock_guard<std::mutex> lock(solvers_mutex_);
+    for (const auto &set : solver_sets_) {
+        if (set->leased) {
+            set->stale = true;
+            continue;
+        }
+        for (const auto &solver : set->solvers) {
+            solver->clear();
+        }
+    }
+}
+
+void TranspositionTable::newSearch() {
+    std::uint8_t generation = generation_.load(std::memory_order_relaxed);
+    generation_.store(static_cast<std::uint8_t>((generation + 1) & 63), std::memory_order_relaxed);
+}
+
+TranspositionTable::SolverLease::SolverLease(TranspositionTable &table, int threads) : table_(table) {
+    std::lock_guard<std::mutex> lock(table_.solvers_mutex_);
+    for (const auto &set : table_.solver_sets_) {
+        if (!set->leased) {
+            set_ = set.get();
+            break;
+        }
+    }
+    if (!set_) {
+        table_.solver_sets_.push_back(std::make_unique<ThreatSolverSet>());
+        set_ = table_.solver_sets_.back().get();
+    }
+    set_->leased = true;
+    while (set_->solvers.size() < static_cast<std::size_t>(threads)) {
+        set_->solvers.push_back(std::make_unique<ThreatSolver>());
+    }
+}
+
+TranspositionTable::SolverLease::~SolverLease() {
+    std::lock_guard<std::mutex> lock(table_.solvers_mutex_);
+    if (set_->stale) {
+        for (const auto &solver : set_->solvers) {
+            solver->clear();
+        }
+        set_->stale = false;
+    }
+    set_->leased = false;
+}
+
+ThreatSolver &TranspositionTable::SolverLease::solver(int worker) const {
+    return *set_->solvers[worker];
+}
+
+std::size_t TranspositionTable::threatSolverBytes() const {
+    std::lock_guard<std::mutex> lock(solvers_mutex_);
+    std::size_t bytes = 0;
+    for (const auto &set : solver_sets_) {
+        for (const auto &solver : set->solvers) {
+            bytes += solver->memoryBytes();
+        }
+    }
+    return bytes;
+}
+
+int TranspositionTable::ageOf(std::uint64_t data) const {
+    return (generation_.load(std::memory_order_relaxed) - GenerationOf(data)) & 63;
+}
+
+TranspositionTable::StatShard &TranspositionTable::shardFor(std::array<StatShard, kStatShards> &shards) {
+    thread_local unsigned shard = next_shard.fetch_add(1, std::memory_order_relaxed) % kStatShards;
+    return shards[shard];
+}
+
+bool TranspositionTable::probe(std::uint64_t key, TranspositionEntry &entry) {
+    StatShard &counters = shardFor(stats_);
+    counters.probes.fetch_add(1, std::memory_order_relaxed);
+    for (Slot &slot : bucketFor(key).slots) {
+        std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+        std::uint64_t check = slot.check.load(std::memory_order_relaxed);
+        if ((check ^ data) != key || BoundOf(data) == BoundType::None) {
+            continue;
+        }
+        entry.score = ScoreOf(data);
+        entry.depth = DepthOf(data);
+        entry.bound = BoundOf(data);
+        entry.move = MoveOf(data);
+        if (ageOf(data) != 0) {
+            std::uint64_t refreshed = Pack(entry.score, entry.move, entry.depth, entry.bound,
+                                           generation_.load(std::memory_order_relaxed));
+            slot.data.store(refreshed, std::memory_order_relaxed);
+            slot.check.store(key ^ refreshed, std::memory_order_relaxed);
+        }
+        counters.hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void TranspositionTable::store(std::uint64_t key, int depth, int score, BoundType bound, int move) {
+    StatShard &counters = shardFor(stats_);
+    counters.stores.fetch_add(1, std::memory_order_relaxed);
+    Bucket &bucket = bucketFor(key);
+    Slot *victim = nullptr;
+    std::uint64_t victim_data = 0;
+    bool same_key = false;
+    int victim_value = 0;
+    for (Slot &slot : bucket.slots) {
+        std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+        std::uint64_t check = slot.check.load(std::memory_order_relaxed);
+        if (BoundOf(data) == BoundType::None || (check ^ data) == key) {
+            victim = &slot;
+            victim_data = data;
+            same_key = BoundOf(data) != BoundType::None;
+            break;
+        }
+        int value = DepthOf(data) - ageOf(data) * 8;
+        if (!victim || value < victim_value) {
+            victim = &slot;
+            victim_data = data;
+            victim_value = value;
+        }
+    }
+
+    if (same_key) {
+        if (move < 0) {
+            move = MoveOf(victim_data);
+        }
+        if (bound != BoundType::Exact && depth < DepthOf(victim_data) && ageOf(victim_data) == 0) {
+            return;
+        }
+    } else if (BoundOf(victim_data) != BoundType::None && ageOf(victim_data) == 0) {
+        counters.collisions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::uint64_t data = Pack(score, move, depth, bound, generation_.load(std::memory_order_relaxed));
+    victim->data.store(data, std::memory_order_relaxed);
+    victim->check.store(key ^ data, std::memory_order_relaxed);
+}
+
+TranspositionStats TranspositionTable::stats() const {
+    TranspositionStats total;
+    for (const StatShard &shard : stats_) {
+        total.probes += shard.probes.load(std::memory_order_relaxed);
+        total.hits += shard.hits.load(std::memory_order_relaxed);
+        total.stores += shard.stores.load(std::memory_order_relaxed);
+        total.collisions += shard.collisions.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void TranspositionTable::resetStats() {
+    for (StatShard &shard : stats_) {
+        shard.probes.store(0, std::memory_order_relaxed);
+        shard.hits.store(0, std::memory_order_relaxed);
+        shard.stores.store(0, std::memory_order_relaxed);
+        shard.collisions.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,123 @@
+#ifndef GOMOKU_TRANSPOSITION_TABLE_H
+#define GOMOKU_TRANSPOSITION_TABLE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class ThreatSolver;
+struct ThreatSolverSet;
+
+enum class BoundType : std::uint8_t {
+    None,
+    Exact,
+    Lower,
+    Upper
+};
+
+struct TranspositionEntry {
+    int score = 0;
+    int depth = 0;
+    BoundType bound = BoundType::None;
+    int move = -1;
+};
+
+struct TranspositionStats {
+    std::uint64_t probes = 0;
+    std::uint64_t hits = 0;
+    std::uint64_t stores = 0;
+    std::uint64_t collisions = 0;
+};
+
+// Fixed-size hash table of search results keyed by Zobrist hash. Slots are
+// grouped into 64-byte buckets; each slot records the generation of the search
+// that wrote it so entries from earlier moves of a match stay probeable but
+// are the first to be replaced. Moves are stored as y * Size + x for the
+// board size of the search that stored them. Sizes may share a table, since
+// their hashes never coincide (see BasicGomokuGame::emptyHash).
+//
+// The table is safe to share between search threads without locks: a slot is
+// two relaxed atomic words, the packed data and the key xor-ed with it, so a
+// torn write fails verification and reads as a miss.
+//
+// The table also keeps the searches' threat solvers, so their tables are
+// allocated once and their proofs carry over to the next search, just like
+// the table's entries. A search borrows a set of them, one per thread,
+// through a SolverLease; searches running at the same time get different
+// sets.
+class TranspositionTable {
+public:
+    static constexpr std::size_t kDefaultMegabytes = 16;
+
+    explicit TranspositionTable(std::size_t megabytes = kDefaultMegabytes);
+    ~TranspositionTable();
+
+    void resize(std::size_t megabytes);
+    void clear();
+    void newSearch();
+
+    bool probe(std::uint64_t key, TranspositionEntry &entry);
+    void store(std::uint64_t key, int depth, int score, BoundType bound, int move);
+
+    // One search's threat solvers, held for as long as the lease lives. The
+    // table must outlive it.
+    class SolverLease {
+    public:
+        SolverLease(TranspositionTable &table, int threads);
+        ~SolverLease();
+
+        SolverLease(const SolverLease &) = delete;
+        SolverLease &operator=(const SolverLease &) = delete;
+
+        ThreatSolver &solver(int worker) const;
+
+    private:
+        TranspositionTable &table_;
+        ThreatSolverSet *set_ = nullptr;
+    };
+
+    std::size_t threatSolverBytes() const;
+
+    std::size_t sizeMegabytes() const { return megabytes_; }
+    TranspositionStats stats() const;
+    void resetStats();
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> check{0};
+        std::atomic<std::uint64_t> data{0};
+    };
+
+    static constexpr int kSlotsPerBucket = 4;
+    static constexpr int kStatShards = 16;
+
+    struct alignas(64) Bucket {
+        std::array<Slot, kSlotsPerBucket> slots;
+    };
+
+    struct alignas(64) StatShard {
+        std::atomic<std::uint64_t> probes{0};
+        std::atomic<std::uint64_t> hits{0};
+        std::atomic<std::uint64_t> stores{0};
+        std::atomic<std::uint64_t> collisions{0};
+    };
+
+    int ageOf(std::uint64_t data) const;
+    Bucket &bucketFor(std::uint64_t key) { return buckets_[key & (bucket_count_ - 1)]; }
+    static StatShard &shardFor(std::array<StatShard, kStatShards> &shards);
+
+    std::unique_ptr<Bucket[]> buckets_;
+    std::size_t bucket_count_ = 0;
+    std::size_t megabytes_ = 0;
+    std::atomic<std::uint8_t> generation_{0};
+    std::array<StatShard, kStatShards> stats_{};
+    // Guards the solver sets; a set is only used by the lease holding it.
+    mutable std::mutex solvers_mutex_;
+    std::vector<std::unique_ptr<ThreatSolverSet>> solver_sets_;
+};
+
+#endif
@@ -7,6 +7,8 @@
 
 #include "gomoku.h"
 #include "gomoku_ai.h"
+#include "opening_book.h"
+#include "ponder_search.h"
 
 namespace {
 
@@ -15,11 +17,18 @@ constexpr int kMargin = 40;
 constexpr int kAiTimerId = 1;
 constexpr int kGlowTimerId = 2;
 constexpr int kPulseTimerId = 3;
+constexpr int kAiPollTimerId = 4;
 constexpr UINT kGlowIntervalMs = 33;
 constexpr UINT kPulseIntervalMs = 30;
+constexpr UINT kAiPollIntervalMs = 15;
 constexpr int kPulseFrames = 7;
 constexpr int kWindowWidth = 700;
 constexpr int kWindowHeight = 820;
+// Optional; read from the working directory when the window is created.
+constexpr char kBookPath[] = "gomoku.book";
+// Hard's time per move. With a budget the search deepens until it runs out,
+// and the ponder search keeps going for as long as the player thinks.
+constexpr int kHardMoveTimeMs = 1000;
 
 enum class Scene {
     Menu,
@@ -41,10 +50,15 @@ struct GameState {
     int pulse_frame = 0;
     int pulse_total = 0;
     bool ai_pending = false;
+    OpeningBook book;
+    // Declared after the book it reads, so it is stopped first. Between AI
+    // moves it ponders on the human's time.
+    PonderSearch search;
 };
 
 static void StartAiTimer(HWND hwnd);
-static void DoAiMove(GameState &state, HWND hwnd);
+static void StartAiSearch(GameState &state, HWND hwnd);
+static void FinishAiMove(GameState &state, HWND hwnd);
 
 int ScaleByDpi(UINT dpi, int value) {
     return MulDiv(value, static_cast<int>(dpi), 96);
@@ -172,7 +186,9 @@ void ResetGame(GameState &state, HWND hwnd) {
     state.pulse_frame = 0;
     state.pulse_total = 0;
     state.ai_pending = false;
+    state.search.stop();
     KillTimer(hwnd, kAiTimerId);
+    KillTimer(hwnd, kAiPollTimerId);
     KillTimer(hwnd, kGlowTimerId);
     KillTimer(hwnd, kPulseTimerId);
     InvalidateRect(hwnd, nullptr, TRUE);
@@ -472,6 +488,7 @@ void StartPulseTimer(GameState &state, HWND hwnd) {
 }
 
 void SetWinState(GameState &state, HWND hwnd, int winner, const std::optional<WinLine> &line) {
+    state.search.stop();
     state.winner = winner;
     state.win_line = line;
     state.win_cells.clear();
@@ -483,8 +500,11 @@ void SetWinState(GameState &state, HWND hwnd, int winner, const std::optional<Wi
 }
 
 void HandleUndo(GameState &state, HWND hwnd) {
+    // Stops pondering too: the position it searches is about to go away.
+    state.search.stop();
     if (state.ai_pending) {
         KillTimer(hwnd, kAiTimerId);
+        KillTimer(hwnd, kAiPollTimerId);
         state.ai_pending = false;
     }
 
@@ -508,24 +528,41 @@ void HandleUndo(GameState &state, HWND hwnd) {
     InvalidateRect(hwnd, nullptr, TRUE);
 }
 
-static void DoAiMove(GameState &state, HWND hwnd) {
-    state.ai_pending = false;
-    if (state.scene != Scene::Playing || state.winner != GomokuGame::kEmpty || state.game.isBoardFull()) {
-        return;
-    }
-    if (state.game.currentPlayer() != state.ai_player) {
+AiSearchOptions AiOptions(const GameState &state) {
+    AiSearchOptions options;
+    options.book = state.book.isOpen() ? &state.book : nullptr;
+    options.time_budget_ms = kHardMoveTimeMs;
+    return options;
+}
+
+// Searches on a worker thread, or keeps the ponder search when it guessed
+// the human's move; the poll timer picks up the result, so the window keeps
+// painting and handling input meanwhile.
+static void StartAiSearch(GameState &state, HWND hwnd) {
+    if (state.scene != Scene::Playing || state.winner != GomokuGame::kEmpty || state.game.isBoardFull()
+        || state.game.currentPlayer() != state.ai_player) {
+        state.ai_pending = false;
         return;
     }
-    auto move = ComputeAiMove(state.game, state.ai_player, state.human_player, state.difficulty);
+    state.search.beginMove(state.game, state.ai_player, state.human_player, state.difficulty, AiOptions(state));
+    SetTimer(hwnd, kAiPollTimerId, kAiPollIntervalMs, nullptr);
+}
+
+static void FinishAiMove(GameState &state, HWND hwnd) {
+    KillTimer(hwnd, kAiPollTimerId);
+    state.ai_pending = false;
+    auto move = state.search.finish().move;
     if (state.game.placeStone(move.first, move.second, state.ai_player)) {
         StartPulseTimer(state, hwnd);
         std::optional<WinLine> win_line = state.game.findWinningLine(move.first, move.second, state.ai_player);
         if (win_line) {
             SetWinState(state, hwnd, state.ai_player, win_line);
         } else if (state.game.isBoardFull()) {
+            state.search.stop();
             state.scene = Scene::GameOver;
         } else {
             state.game.setCurrentPlayer(state.human_player);
+            state.search.ponder(state.game, state.ai_player, state.human_player, state.difficulty, AiOptions(state));
         }
     }
 }
@@ -536,6 +573,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT message, WPARAM wparam, LPARAM lpara
     switch (message) {
         case WM_CREATE: {
             auto *created_state = new GameState{};
+            created_state->book.open(kBookPath);
             SetWindowLongPtr(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(created_state));
             return 0;
         }
@@ -605,6 +643,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT message, WPARAM wparam, LPARAM lpara
             if (win_line) {
                 SetWinState(*state, hwnd, state->human_player, win_line);
             } else if (state->game.isBoardFull()) {
+                state->search.stop();
                 state->scene = Scene::GameOver;
             } else {
                 state->game.setCurrentPlayer(state->ai_player);
@@ -620,8 +659,14 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT message, WPARAM wparam, LPARAM lpara
             }
             if (wparam == kAiTimerId) {
                 KillTimer(hwnd, kAiTimerId);
-                DoAiMove(*state, hwnd);
-                InvalidateRect(hwnd, nullptr, FALSE);
+                StartAiSearch(*state, hwnd);
+                return 0;
+            }
+            if (wparam == kAiPollTimerId) {
+                if (state->search.done()) {
+                    FinishAiMove(*state, hwnd);
+                    InvalidateRect(hwnd, nullptr, FALSE);
+                }
                 return 0;
             }
             if (wparam == kGlowTimerId) {
@@ -0,0 +1,105 @@
+#include "work_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// The pool and queue index of the pool thread running here, if any.
+thread_local const WorkStealingPool *current_pool = nullptr;
+thread_local int current_index = 0;
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(int threads, std::size_t capacity) : capacity_(std::max<std::size_t>(1, capacity)) {
+    if (threads <= 0) {
+        threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    for (int i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    for (int i = 0; i < threads; ++i) {
+        threads_.emplace_back(&WorkStealingPool::run, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        quit_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread &thread : threads_) {
+        thread.join();
+    }
+}
+
+bool WorkStealingPool::submit(Task task) {
+    if (quit_) {
+        return false;
+    }
+    std::size_t count = queued_.load();
+    do {
+        if (count >= capacity_) {
+            return false;
+        }
+    } while (!queued_.compare_exchange_weak(count, count + 1));
+    std::size_t index = current_pool == this ? static_cast<std::size_t>(current_index) : next_queue_++;
+    Queue &queue = *queues_[index % queues_.size()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+        ++ready_;
+    }
+    // A thread about to sleep counts itself before it checks ready_, and
+    // this reads sleepers_ after raising ready_, so one of the two sees the
+    // other. The lock makes sure a sleeper seen here is already waiting.
+    if (sleepers_ > 0) {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        wake_.notify_one();
+    }
+    return true;
+}
+
+std::size_t WorkStealingPool::queued() const {
+    return queued_;
+}
+
+// With the pool quitting, a thread still runs whatever is queued and
+// returns once every queue is empty.
+void WorkStealingPool::run(int index) {
+    current_pool = this;
+    current_index = index;
+    for (;;) {
+        Task task;
+        if (take(index, task)) {
+            task();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        ++sleepers_;
+        wake_.wait(lock, [this]() { return quit_ || ready_ > 0; });
+        --sleepers_;
+        if (quit_ && ready_ == 0) {
+            return;
+        }
+    }
+}
+
+// Own queue first, then the others from the next one on; oldest task first
+// in each.
+bool WorkStealingPool::take(int index, Task &task) {
+    const std::size_t count = queues_.size();
+    for (std::size_t i = 0; i < count; ++i) {
+        Queue &queue = *queues_[(index + i) % count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            --ready_;
+            --queued_;
+            return true;
+        }
+    }
+    return false;
+}
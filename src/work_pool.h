@@ -0,0 +1,74 @@
+#ifndef GOMOKU_WORK_POOL_H
+#define GOMOKU_WORK_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of threads, each with its own task queue. Submissions are
+// dealt out to the queues in turn, or go to the submitting thread's own
+// queue when a task submits more work. A thread runs its own oldest task
+// first and, with its queue empty, steals the oldest task of another.
+// Tasks are whole searches with a latency target, so owners take from the
+// front too rather than working depth first.
+//
+// The number of queued tasks is bounded: beyond the capacity submit refuses
+// the task instead of queueing it, so the caller can push back on whoever
+// asked for the work.
+//
+// Submitting and taking lock only the queue they touch; the counts are
+// atomic. A thread sleeps only after finding every queue empty, and a
+// submission wakes one only if some thread is asleep.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    // threads <= 0 uses every hardware thread.
+    WorkStealingPool(int threads, std::size_t capacity);
+    // Runs the tasks still queued, then joins the threads.
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    // Returns false, dropping the task, when the queues are full.
+    bool submit(Task task);
+
+    int threadCount() const { return static_cast<int>(threads_.size()); }
+    std::size_t capacity() const { return capacity_; }
+    // Tasks submitted and not yet started.
+    std::size_t queued() const;
+
+private:
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(int index);
+    bool take(int index, Task &task);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    const std::size_t capacity_;
+    std::atomic<std::size_t> next_queue_{0};
+    // Tasks submitted and not yet taken, counted before they are queued so
+    // that the capacity holds, and those of them already in a queue,
+    // counted under the queue's lock.
+    std::atomic<std::size_t> queued_{0};
+    std::atomic<std::size_t> ready_{0};
+    std::atomic<int> sleepers_{0};
+    std::atomic<bool> quit_{false};
+    // Only for sleeping: held while a thread checks ready_ before it waits
+    // and by a submission waking it.
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+};
+
+#endif
@@ -0,0 +1,120 @@
+#include <array>
+#include <random>
+#include <vector>
+
+#include "eval_kernel.h"
+#include "gomoku.h"
+#include "gomoku_eval.h"
+#include "test.h"
+
+namespace {
+
+constexpr int kPositionsPerSize = 200;
+
+// A random position with up to a third of the board filled, stones of
+// either colour anywhere, including along the edges where windows run into
+// the wall padding.
+template <int Size>
+void RandomPosition(std::mt19937 &random, BasicGomokuGame<Size> &game) {
+    game.reset();
+    std::uniform_int_distribution<int> cell(0, Size * Size - 1);
+    int stones = std::uniform_int_distribution<int>(0, Size * Size / 3)(random);
+    for (int i = 0; i < stones; ++i) {
+        int c = cell(random);
+        game.placeStone(c % Size, c / Size, random() % 2 == 0 ? GomokuGame::kBlack : GomokuGame::kWhite);
+    }
+}
+
+template <int Size>
+std::vector<int> EmptyCells(const BasicGomokuGame<Size> &game) {
+    std::vector<int> cells;
+    for (int y = 0; y < Size; ++y) {
+        for (int x = 0; x < Size; ++x) {
+            if (game.at(x, y) == GomokuGame::kEmpty) {
+                cells.push_back(y * Size + x);
+            }
+        }
+    }
+    return cells;
+}
+
+struct KernelOutput {
+    std::vector<int> black;
+    std::vector<int> white;
+    std::vector<int> black_both;
+    std::vector<int> white_both;
+    std::vector<CellThreats> threats;
+};
+
+template <int Size>
+KernelOutput RunKernel(const BasicGomokuGame<Size> &game, const std::vector<int> &cells) {
+    const int count = static_cast<int>(cells.size());
+    KernelOutput out;
+    out.black.resize(cells.size());
+    out.white.resize(cells.size());
+    out.black_both.resize(cells.size());
+    out.white_both.resize(cells.size());
+    out.threats.resize(cells.size());
+    if (count > 0) {
+        EvaluateCells(game, cells.data(), count, GomokuGame::kBlack, out.black.data());
+        EvaluateCells(game, cells.data(), count, GomokuGame::kWhite, out.white.data());
+        EvaluateCellsBoth(game, cells.data(), count, out.black_both.data(), out.white_both.data());
+        ClassifyCells(game, cells.data(), count, out.threats.data());
+    }
+    return out;
+}
+
+template <int Size>
+void CompareKernels(unsigned seed) {
+    std::mt19937 random(seed);
+    BasicGomokuGame<Size> game;
+    for (int p = 0; p < kPositionsPerSize; ++p) {
+        RandomPosition(random, game);
+        std::vector<int> cells = EmptyCells(game);
+        CHECK(SetEvalKernel(EvalKernel::Scalar));
+        KernelOutput scalar = RunKernel(game, cells);
+        CHECK(SetEvalKernel(EvalKernel::Avx2));
+        KernelOutput avx2 = RunKernel(game, cells);
+        for (std::size_t i = 0; i < cells.size(); ++i) {
+            int x = cells[i] % Size;
+            int y = cells[i] / Size;
+            CHECK_EQ(scalar.black[i], EvaluateCell(game, x, y, GomokuGame::kBlack));
+            CHECK_EQ(scalar.white[i], EvaluateCell(game, x, y, GomokuGame::kWhite));
+            CHECK_EQ(avx2.black[i], scalar.black[i]);
+            CHECK_EQ(avx2.white[i], scalar.white[i]);
+            CHECK_EQ(avx2.black_both[i], scalar.black[i]);
+            CHECK_EQ(avx2.white_both[i], scalar.white[i]);
+            CHECK_EQ(scalar.black_both[i], scalar.black[i]);
+            CHECK_EQ(scalar.white_both[i], scalar.white[i]);
+            for (int dir = 0; dir < 4; ++dir) {
+                CHECK_EQ(static_cast<int>(avx2.threats[i].black[dir]), static_cast<int>(scalar.threats[i].black[dir]));
+                CHECK_EQ(static_cast<int>(avx2.threats[i].white[dir]), static_cast<int>(scalar.threats[i].white[dir]));
+            }
+        }
+    }
+}
+
+template <int Size>
+void CheckKernelsAgree(unsigned seed) {
+    const EvalKernel active = ActiveEvalKernel();
+    if (!SetEvalKernel(EvalKernel::Avx2)) {
+        std::printf("skipped: the CPU has no AVX2\n");
+        return;
+    }
+    CompareKernels<Size>(seed);
+    SetEvalKernel(active);
+}
+
+} // namespace
+
+TEST(eval_kernel, avx2_matches_scalar_15) {
+    CheckKernelsAgree<15>(15);
+}
+
+TEST(eval_kernel, avx2_matches_scalar_19) {
+    CheckKernelsAgree<19>(19);
+}
+
+TEST(eval_kernel, avx2_matches_scalar_20) {
+    CheckKernelsAgree<20>(20);
+}
@@ -0,0 +1,225 @@
+#include <cstdio>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "game_record.h"
+#include "gomoku.h"
+#include "test.h"
+
+namespace {
+
+// Plays up to move_count random moves, stopping early when one wins, and
+// returns the game as a record with the matching result.
+template <int Size>
+GameRecord RandomGame(std::mt19937 &random, int move_count) {
+    BasicGomokuGame<Size> game;
+    GameRecord record;
+    record.board_size = Size;
+    std::uniform_int_distribution<int> coordinate(0, Size - 1);
+    int player = GomokuGame::kBlack;
+    while (static_cast<int>(record.moves.size()) < move_count) {
+        int x = coordinate(random);
+        int y = coordinate(random);
+        if (!game.placeStone(x, y, player)) {
+            continue;
+        }
+        record.moves.emplace_back(x, y);
+        if (game.checkWin(x, y, player)) {
+            record.result = player == GomokuGame::kBlack ? GameResult::BlackWin : GameResult::WhiteWin;
+            break;
+        }
+        player = player == GomokuGame::kBlack ? GomokuGame::kWhite : GomokuGame::kBlack;
+    }
+    return record;
+}
+
+GameRecord RandomGame(std::mt19937 &random, int board_size, int move_count) {
+    return WithBoardSize(board_size, [&](auto size) { return RandomGame<decltype(size)::value>(random, move_count); });
+}
+
+void CheckSameRecord(const GameRecord &actual, const GameRecord &expected) {
+    CHECK_EQ(actual.board_size, expected.board_size);
+    CHECK(actual.rules == expected.rules);
+    CHECK(actual.result == expected.result);
+    CHECK(actual.moves == expected.moves);
+}
+
+// Records covering each board size, both cell widths, the far corner cell,
+// every rule set and an empty game.
+std::vector<GameRecord> SampleRecords() {
+    std::mt19937 random(2024);
+    std::vector<GameRecord> records;
+    for (int size : {15, 19, 20}) {
+        for (int move_count : {0, 1, 30, 120}) {
+            records.push_back(RandomGame(random, size, move_count));
+        }
+        GameRecord corners;
+        corners.board_size = size;
+        corners.rules = GameRules::Renju;
+        corners.result = GameResult::Draw;
+        corners.moves = {{size - 1, size - 1}, {0, 0}, {size - 1, 0}, {0, size - 1}};
+        records.push_back(corners);
+    }
+    records[1].rules = GameRules::Standard;
+    return records;
+}
+
+} // namespace
+
+TEST(game_record, binary_round_trip) {
+    const std::string path = TempPath("round_trip.games");
+    std::remove(path.c_str());
+    const std::vector<GameRecord> records = SampleRecords();
+    // Written over two sessions, so the second open appends.
+    const std::size_t half = records.size() / 2;
+    for (std::size_t begin : {std::size_t{0}, half}) {
+        GameRecordWriter writer;
+        CHECK(writer.open(path));
+        for (std::size_t i = begin; i < (begin == 0 ? half : records.size()); ++i) {
+            CHECK(writer.append(records[i]));
+        }
+        CHECK(writer.close());
+    }
+
+    GameRecordReader reader;
+    CHECK(reader.open(path));
+    for (int pass = 0; pass < 2; ++pass) {
+        GameRecordView view;
+        std::size_t count = 0;
+        while (reader.next(view)) {
+            if (count < records.size()) {
+                CheckSameRecord(view.toRecord(), records[count]);
+                CHECK_EQ(view.moveCount(), static_cast<int>(records[count].moves.size()));
+            }
+            ++count;
+        }
+        CHECK_EQ(static_cast<int>(count), static_cast<int>(records.size()));
+        CHECK(!reader.damaged());
+        reader.rewind();
+    }
+    reader.close();
+    std::remove(path.c_str());
+}
+
+TEST(game_record, replays_games) {
+    const std::string path = TempPath("replay.games");
+    std::remove(path.c_str());
+    std::mt19937 random(7);
+    GomokuGame played;
+    const GameRecord record = RandomGame<15>(random, 40);
+    int player = GomokuGame::kBlack;
+    for (const auto &move : record.moves) {
+        played.placeStone(move.first, move.second, player);
+        player = player == GomokuGame::kBlack ? GomokuGame::kWhite : GomokuGame::kBlack;
+    }
+    {
+        GameRecordWriter writer;
+        CHECK(writer.open(path));
+        CHECK(writer.append(played, record.result));
+    }
+
+    GameRecordReader reader;
+    CHECK(reader.open(path));
+    GameRecordView view;
+    CHECK(reader.next(view));
+    CheckSameRecord(view.toRecord(), record);
+    GomokuGame replayed;
+    CHECK(view.replay(replayed));
+    CHECK(replayed.hash() == played.hash());
+    CHECK_EQ(replayed.currentPlayer(), player);
+    BasicGomokuGame<19> other_size;
+    CHECK(!view.replay(other_size));
+    reader.close();
+    std::remove(path.c_str());
+}
+
+TEST(game_record, rejects_bad_records) {
+    const std::string path = TempPath("bad.games");
+    std::remove(path.c_str());
+    GameRecordWriter writer;
+    CHECK(writer.open(path));
+    GameRecord off_board;
+    off_board.moves = {{7, 7}, {15, 3}};
+    CHECK(!writer.append(off_board));
+    GameRecord unsupported;
+    unsupported.board_size = 16;
+    CHECK(!writer.append(unsupported));
+    std::mt19937 random(11);
+    const GameRecord first = RandomGame(random, 15, 20);
+    const GameRecord second = RandomGame(random, 20, 20);
+    CHECK(writer.append(first));
+    CHECK(writer.append(second));
+    CHECK(writer.close());
+
+    // A record cut short ends the file for readers, after the whole ones.
+    std::vector<unsigned char> bytes = ReadBytes(path);
+    bytes.pop_back();
+    CHECK(WriteBytes(path, bytes));
+    GameRecordReader reader;
+    CHECK(reader.open(path));
+    GameRecordView view;
+    CHECK(reader.next(view));
+    CheckSameRecord(view.toRecord(), first);
+    CHECK(!reader.next(view));
+    CHECK(reader.damaged());
+    reader.close();
+
+    // A file of something else is neither read nor appended to.
+    std::vector<unsigned char> foreign(64, 'x');
+    CHECK(WriteBytes(path, foreign));
+    CHECK(!reader.open(path));
+    CHECK(!writer.open(path));
+    CHECK(ReadBytes(path) == foreign);
+    std::remove(path.c_str());
+}
+
+TEST(game_record, psq_round_trip) {
+    std::mt19937 random(5);
+    for (int size : {15, 19, 20}) {
+        for (int move_count : {0, 9, 200}) {
+            const GameRecord record = RandomGame(random, size, move_count);
+            const std::string text = FormatPsq(record);
+            GameRecord parsed;
+            CHECK(ParsePsq(text, parsed));
+            CheckSameRecord(parsed, record);
+            CHECK(FormatPsq(parsed) == text);
+        }
+    }
+
+    // Moves end at the first line that is not one; trailers are ignored.
+    GameRecord parsed;
+    CHECK(ParsePsq("Piskvorky 20x20, 11:11, 0\n1,1,0\n20,20,125\n2,1,0\npbrain-engine.exe\n-1\n", parsed));
+    CHECK_EQ(parsed.board_size, 20);
+    CHECK(parsed.moves == (std::vector<std::pair<int, int>>{{0, 0}, {19, 19}, {1, 0}}));
+    CHECK(parsed.result == GameResult::Unknown);
+
+    // The result comes from replaying the moves.
+    CHECK(ParsePsq("Piskvorky 15x15, 8:8, 0\n1,1,0\n1,2,0\n2,1,0\n2,2,0\n3,1,0\n3,2,0\n4,1,0\n4,2,0\n5,1,0\n",
+                   parsed));
+    CHECK(parsed.result == GameResult::BlackWin);
+}
+
+TEST(game_record, rejects_malformed_psq) {
+    const char *const kMalformed[] = {
+        "",
+        "1,1,0\n",
+        "Piskvork 15x15, 8:8, 0\n1,1,0\n",
+        "Piskvorky 15x19, 8:8, 0\n1,1,0\n",
+        "Piskvorky 16x16, 9:9, 0\n1,1,0\n",
+        "Piskvorky 15x15, 8:8, 0\n0,1,0\n",
+        "Piskvorky 15x15, 8:8, 0\n1,16,0\n",
+        "Piskvorky 15x15, 8:8, 0\n-3,4,0\n",
+        // The same cell twice.
+        "Piskvorky 15x15, 8:8, 0\n8,8,0\n9,9,0\n8,8,0\n",
+        // A move after black has already won.
+        "Piskvorky 15x15, 8:8, 0\n1,1,0\n1,2,0\n2,1,0\n2,2,0\n3,1,0\n3,2,0\n4,1,0\n4,2,0\n5,1,0\n5,2,0\n",
+    };
+    for (const char *text : kMalformed) {
+        GameRecord parsed;
+        if (ParsePsq(text, parsed)) {
+            RecordFailure(__FILE__, __LINE__, std::string("accepted malformed psq: ") + text);
+        }
+    }
+}
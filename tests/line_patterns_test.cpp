@@ -0,0 +1,168 @@
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+
+#include "bitboard.h"
+#include "eval_kernel.h"
+#include "gomoku.h"
+#include "line_patterns.h"
+#include "test.h"
+
+namespace {
+
+using patterns::Threat;
+
+// A nine-lane window, centre in the middle, from the side of the player to
+// move: 'X' the player, 'O' the opponent, '#' the wall, '.' empty. The
+// centre must be 'X'.
+struct WindowCase {
+    const char *window;
+    Threat threat;
+    int level;
+};
+
+const WindowCase kWindowCases[] = {
+    // Fives, solid and from either end.
+    {"..XXXXX..", Threat::Five, 8},
+    {"XXXXX....", Threat::Five, 8},
+    {"....XXXXX", Threat::Five, 8},
+    {"OXXXXXO..", Threat::Five, 8},
+    // Fours: one cell left to complete five.
+    {"...XX.XX.", Threat::Four, 6},
+    {"..X.XXX..", Threat::Four, 6},
+    {"..XXX.X..", Threat::Four, 6},
+    {"...OXXXX.", Threat::Four, 6},
+    {"..OXXXX..", Threat::Four, 6},
+    // Open fours: two completion cells.
+    {"..XXXX...", Threat::OpenFour, 7},
+    {"...XXXX..", Threat::OpenFour, 7},
+    // A split shape with completions on both sides counts as open.
+    {"X.XXX.X..", Threat::OpenFour, 7},
+    // Threes, solid and broken, open and closed.
+    {"...XXX...", Threat::OpenThree, 5},
+    {"..X.XX...", Threat::OpenThree, 5},
+    {"...XX.X..", Threat::OpenThree, 5},
+    {"..OXXX...", Threat::Three, 4},
+    {"...OX.XX.", Threat::Three, 4},
+    {"X..XX....", Threat::Three, 4},
+    {"..X.X.X..", Threat::Three, 4},
+    // Dead shapes: no room left for five.
+    {"..OXXXXO.", Threat::None, 0},
+    {"..OXXXO..", Threat::None, 0},
+    // Twos and lone stones only score by their run.
+    {"...XX....", Threat::None, 3},
+    {"..OXX....", Threat::None, 2},
+    {"....X....", Threat::None, 1},
+};
+
+// The wall is blocked, like an opponent stone.
+const WindowCase kWallCases[] = {
+    {"#XXXX....", Threat::Four, 6},
+    {"....XXXX#", Threat::Four, 6},
+    {"##XXXXX##", Threat::Five, 8},
+    {"#XXXX#...", Threat::None, 0},
+    {"##XXX....", Threat::Three, 4},
+    {"....XXX##", Threat::Three, 4},
+    // Walled in shapes keep their run level, which only sees the neighbours.
+    {"###.X.###", Threat::None, 1},
+    {"###XX.###", Threat::None, 2},
+};
+
+// Lays the window on lanes 4..12 of a line word and reads the pattern of
+// its centre, lane 8.
+patterns::LinePattern PatternOf(const char *window, int player) {
+    const int opponent = GomokuGame::kBlack + GomokuGame::kWhite - player;
+    std::uint64_t word = 0;
+    for (int i = 0; i < patterns::kWindowLanes; ++i) {
+        std::uint64_t lane = bitboard::kLaneEmpty;
+        if (window[i] == 'X') {
+            lane = static_cast<std::uint64_t>(player);
+        } else if (window[i] == 'O') {
+            lane = static_cast<std::uint64_t>(opponent);
+        } else if (window[i] == '#') {
+            lane = bitboard::kLaneWall;
+        }
+        word |= lane << ((i + 4) * 2);
+    }
+    return patterns::PatternAt(word, 4 + patterns::kCenter, player);
+}
+
+void CheckCases(const WindowCase *cases, std::size_t count) {
+    for (std::size_t c = 0; c < count; ++c) {
+        const WindowCase &expected = cases[c];
+        CHECK(std::strlen(expected.window) == patterns::kWindowLanes && expected.window[patterns::kCenter] == 'X');
+        for (int player : {GomokuGame::kBlack, GomokuGame::kWhite}) {
+            patterns::LinePattern pattern = PatternOf(expected.window, player);
+            if (pattern.threat != expected.threat || pattern.level != expected.level) {
+                RecordFailure(__FILE__, __LINE__,
+                              std::string(expected.window) + " for player " + std::to_string(player) + ": threat "
+                                  + std::to_string(static_cast<int>(pattern.threat)) + " level "
+                                  + std::to_string(pattern.level) + ", expected threat "
+                                  + std::to_string(static_cast<int>(expected.threat)) + " level "
+                                  + std::to_string(expected.level));
+            }
+        }
+    }
+}
+
+// Horizontal threat class at (x, y) for black, through the game's own line
+// words and their wall padding.
+template <int Size>
+Threat RowThreat(const BasicGomokuGame<Size> &game, int x, int y) {
+    int cell = y * Size + x;
+    CellThreats threats;
+    ClassifyCells(game, &cell, 1, &threats);
+    return threats.black[0];
+}
+
+template <int Size>
+void CheckBoardEdges() {
+    // Three stones against the right edge: the cell before them makes a four
+    // that can only be completed away from the wall.
+    BasicGomokuGame<Size> game;
+    for (int x = Size - 3; x < Size; ++x) {
+        game.placeStone(x, 3, GomokuGame::kBlack);
+    }
+    CHECK(RowThreat(game, Size - 4, 3) == Threat::Four);
+
+    // The same against the left edge, one cell further out: open on the
+    // inside only, so still a plain four.
+    game.reset();
+    for (int x = 0; x < 3; ++x) {
+        game.placeStone(x, Size - 1, GomokuGame::kBlack);
+    }
+    CHECK(RowThreat(game, 3, Size - 1) == Threat::Four);
+
+    // One cell away from the wall both ends are free.
+    game.reset();
+    for (int x = 1; x < 4; ++x) {
+        game.placeStone(x, 0, GomokuGame::kBlack);
+    }
+    CHECK(RowThreat(game, 4, 0) == Threat::OpenFour);
+
+    // A closed three, then walled in to four cells: no room for five.
+    game.reset();
+    game.placeStone(Size - 1, 5, GomokuGame::kWhite);
+    game.placeStone(Size - 3, 5, GomokuGame::kBlack);
+    game.placeStone(Size - 2, 5, GomokuGame::kBlack);
+    CHECK(RowThreat(game, Size - 4, 5) == Threat::Three);
+    game.placeStone(Size - 6, 5, GomokuGame::kWhite);
+    CHECK(RowThreat(game, Size - 4, 5) == Threat::None);
+}
+
+} // namespace
+
+TEST(line_patterns, windows) {
+    CheckCases(kWindowCases, std::size(kWindowCases));
+}
+
+TEST(line_patterns, walls) {
+    CheckCases(kWallCases, std::size(kWallCases));
+}
+
+TEST(line_patterns, board_edges) {
+    CheckBoardEdges<15>();
+    CheckBoardEdges<19>();
+    CheckBoardEdges<20>();
+}
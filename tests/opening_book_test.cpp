@@ -0,0 +1,141 @@
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gomoku.h"
+#include "opening_book.h"
+#include "test.h"
+
+namespace {
+
+constexpr int kLast = GomokuGame::kBoardSize - 1;
+
+// The eight rotations and reflections, written out independently of the
+// book's own symmetry encoding.
+std::pair<int, int> Orient(int orientation, int x, int y) {
+    switch (orientation) {
+    case 0: return {x, y};
+    case 1: return {kLast - y, x};
+    case 2: return {kLast - x, kLast - y};
+    case 3: return {y, kLast - x};
+    case 4: return {kLast - x, y};
+    case 5: return {x, kLast - y};
+    case 6: return {y, x};
+    default: return {kLast - y, kLast - x};
+    }
+}
+
+// An opening with no symmetry of its own, so each orientation is a
+// different board.
+const std::pair<int, int> kOpening[] = {{7, 7}, {8, 6}, {9, 7}, {7, 9}, {6, 8}};
+
+GomokuGame Oriented(int orientation, int moves = static_cast<int>(std::size(kOpening))) {
+    GomokuGame game;
+    int player = GomokuGame::kBlack;
+    for (int i = 0; i < moves; ++i) {
+        std::pair<int, int> cell = Orient(orientation, kOpening[i].first, kOpening[i].second);
+        game.placeStone(cell.first, cell.second, player);
+        player = GomokuGame::kBlack + GomokuGame::kWhite - player;
+    }
+    return game;
+}
+
+} // namespace
+
+TEST(opening_book, orientations_share_a_key) {
+    int symmetry = 0;
+    const std::uint64_t key = OpeningBook::canonicalKey(Oriented(0), symmetry);
+    for (int orientation = 1; orientation < 8; ++orientation) {
+        CHECK(OpeningBook::canonicalKey(Oriented(orientation), symmetry) == key);
+    }
+    CHECK(OpeningBook::canonicalKey(Oriented(0, 4), symmetry) != key);
+}
+
+TEST(opening_book, probe_maps_moves_back) {
+    // Each orientation writes the book once and probes every orientation
+    // from the reopened file.
+    const std::pair<int, int> move{10, 6};
+    const std::string path = TempPath("opening.book");
+    for (int written = 0; written < 8; ++written) {
+        OpeningBookWriter writer;
+        std::pair<int, int> oriented = Orient(written, move.first, move.second);
+        writer.add(Oriented(written), oriented);
+        CHECK(writer.save(path));
+
+        OpeningBook book;
+        CHECK(book.open(path));
+        CHECK_EQ(static_cast<int>(book.size()), 1);
+        for (int probed = 0; probed < 8; ++probed) {
+            std::pair<int, int> found{-1, -1};
+            CHECK(book.probe(Oriented(probed), found));
+            std::pair<int, int> expected = Orient(probed, move.first, move.second);
+            CHECK_EQ(found.first, expected.first);
+            CHECK_EQ(found.second, expected.second);
+        }
+        std::pair<int, int> found;
+        CHECK(!book.probe(Oriented(written, 4), found));
+    }
+    std::remove(path.c_str());
+}
+
+TEST(opening_book, weights_add_across_orientations) {
+    // The same move added from two orientations outweighs a move added once
+    // with a higher weight.
+    OpeningBookWriter writer;
+    const std::pair<int, int> common{10, 6};
+    const std::pair<int, int> rare{5, 5};
+    writer.add(Oriented(0), common, 2);
+    std::pair<int, int> mirrored = Orient(6, common.first, common.second);
+    writer.add(Oriented(6), mirrored, 2);
+    writer.add(Oriented(0), rare, 3);
+    CHECK_EQ(static_cast<int>(writer.size()), 2);
+
+    const std::string path = TempPath("weights.book");
+    CHECK(writer.save(path));
+    OpeningBook book;
+    CHECK(book.open(path));
+    std::pair<int, int> found{-1, -1};
+    CHECK(book.probe(Oriented(3), found));
+    std::pair<int, int> expected = Orient(3, common.first, common.second);
+    CHECK_EQ(found.first, expected.first);
+    CHECK_EQ(found.second, expected.second);
+    book.close();
+    std::remove(path.c_str());
+}
+
+TEST(opening_book, rejects_malformed_files) {
+    OpeningBookWriter writer;
+    writer.add(Oriented(0), {10, 6});
+    const std::string path = TempPath("malformed.book");
+    CHECK(writer.save(path));
+
+    const std::vector<unsigned char> bytes = ReadBytes(path);
+    CHECK_EQ(static_cast<int>(bytes.size()), 16 + 12);
+
+    auto write_and_open = [&](const std::vector<unsigned char> &contents) {
+        CHECK(WriteBytes(path, contents));
+        OpeningBook book;
+        return book.open(path);
+    };
+    CHECK(write_and_open(bytes));
+
+    std::vector<unsigned char> truncated(bytes.begin(), bytes.end() - 1);
+    CHECK(!write_and_open(truncated));
+    std::vector<unsigned char> bad_magic = bytes;
+    bad_magic[0] ^= 1;
+    CHECK(!write_and_open(bad_magic));
+    std::vector<unsigned char> bad_version = bytes;
+    bad_version[8] += 1;
+    CHECK(!write_and_open(bad_version));
+    std::vector<unsigned char> bad_count = bytes;
+    bad_count[12] += 1;
+    CHECK(!write_and_open(bad_count));
+
+    std::remove(path.c_str());
+    OpeningBook book;
+    CHECK(!book.open(path));
+    CHECK(!book.isOpen());
+}
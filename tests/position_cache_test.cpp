@@ -0,0 +1,104 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "position_cache.h"
+#include "test.h"
+
+namespace {
+
+constexpr std::uint64_t kKey = 0x0123456789ABCDEFULL;
+
+// Creates a 1MB cache for board_size holding one entry under kKey, and
+// returns the bytes of the closed file.
+std::vector<unsigned char> CreateCache(const std::string &path, int board_size) {
+    std::remove(path.c_str());
+    PositionCache cache;
+    CHECK(cache.open(path, 1, board_size));
+    TranspositionEntry entry;
+    entry.score = -1234;
+    entry.depth = 9;
+    entry.bound = BoundType::Lower;
+    entry.move = 112;
+    cache.store({CachedPosition{kKey, entry}});
+    cache.close();
+    return ReadBytes(path);
+}
+
+// A refused file must be left exactly as it was: the engine carries on
+// without the cache and the file may belong to something else.
+void CheckRefused(const std::string &path, const std::vector<unsigned char> &bytes, int board_size) {
+    CHECK(WriteBytes(path, bytes));
+    PositionCache cache;
+    CHECK(!cache.open(path, 1, board_size));
+    CHECK(!cache.isOpen());
+    TranspositionEntry entry;
+    CHECK(!cache.probe(kKey, entry));
+    CHECK(ReadBytes(path) == bytes);
+}
+
+} // namespace
+
+TEST(position_cache, round_trip) {
+    const std::string path = TempPath("round_trip.cache");
+    const std::vector<unsigned char> bytes = CreateCache(path, 15);
+    CHECK(bytes.size() > 64);
+
+    PositionCache cache;
+    CHECK(cache.open(path, 4, 15));
+    CHECK_EQ(cache.boardSize(), 15);
+    CHECK_EQ(static_cast<int>(cache.sizeMegabytes()), 1);
+    TranspositionEntry entry;
+    CHECK(cache.probe(kKey, entry));
+    CHECK_EQ(entry.score, -1234);
+    CHECK_EQ(entry.depth, 9);
+    CHECK(entry.bound == BoundType::Lower);
+    CHECK_EQ(entry.move, 112);
+    CHECK(!cache.probe(kKey ^ 1, entry));
+    cache.close();
+    std::remove(path.c_str());
+}
+
+TEST(position_cache, refuses_truncated_files) {
+    const std::string path = TempPath("truncated.cache");
+    const std::vector<unsigned char> bytes = CreateCache(path, 15);
+    CheckRefused(path, std::vector<unsigned char>(bytes.begin(), bytes.end() - 1), 15);
+    CheckRefused(path, std::vector<unsigned char>(bytes.begin(), bytes.begin() + bytes.size() / 2), 15);
+    CheckRefused(path, std::vector<unsigned char>(bytes.begin(), bytes.begin() + 40), 15);
+    std::vector<unsigned char> extended = bytes;
+    extended.push_back(0);
+    CheckRefused(path, extended, 15);
+    std::remove(path.c_str());
+}
+
+TEST(position_cache, refuses_corrupted_headers) {
+    const std::string path = TempPath("corrupted.cache");
+    const std::vector<unsigned char> bytes = CreateCache(path, 15);
+    // Magic, version, bucket count, fingerprint and checksum in turn.
+    for (int offset : {0, 8, 16, 24, 32, 39}) {
+        std::vector<unsigned char> corrupted = bytes;
+        corrupted[offset] ^= 0x10;
+        CheckRefused(path, corrupted, 15);
+    }
+    // A file that was never a cache, of the size a new one would have.
+    std::vector<unsigned char> foreign(bytes.size(), 0x5A);
+    CheckRefused(path, foreign, 15);
+    std::remove(path.c_str());
+}
+
+TEST(position_cache, refuses_other_board_sizes) {
+    const std::string path = TempPath("board_size.cache");
+    for (int written : {15, 19, 20}) {
+        const std::vector<unsigned char> bytes = CreateCache(path, written);
+        for (int opened : {15, 19, 20}) {
+            if (opened != written) {
+                CheckRefused(path, bytes, opened);
+            }
+        }
+        PositionCache cache;
+        CHECK(cache.open(path, 1, written));
+    }
+    PositionCache cache;
+    CHECK(!cache.open(path, 1, 16));
+    std::remove(path.c_str());
+}
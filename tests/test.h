@@ -0,0 +1,56 @@
+#ifndef GOMOKU_TESTS_TEST_H
+#define GOMOKU_TESTS_TEST_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// A minimal harness with no dependencies. TEST(group, name) registers a
+// test; CHECK records a failure with its location and carries on, so one run
+// reports every mismatch. ctest runs each group as its own test.
+struct TestCase {
+    std::string group;
+    std::string name;
+    void (*run)();
+};
+
+std::vector<TestCase> &TestRegistry();
+void RecordFailure(const char *file, int line, const std::string &message);
+
+// Path for a scratch file named name in the system temporary directory.
+std::string TempPath(const std::string &name);
+// Whole-file helpers for tests that damage files on purpose. ReadBytes
+// returns an empty vector when the file cannot be read.
+std::vector<unsigned char> ReadBytes(const std::string &path);
+bool WriteBytes(const std::string &path, const std::vector<unsigned char> &bytes);
+
+struct TestRegistration {
+    TestRegistration(const char *group, const char *name, void (*run)()) {
+        TestRegistry().push_back(TestCase{group, name, run});
+    }
+};
+
+#define TEST(group, name)                                                                \
+    static void group##_##name();                                                        \
+    static const TestRegistration group##_##name##_registration(#group, #name, group##_##name); \
+    static void group##_##name()
+
+#define CHECK(condition)                                                                 \
+    do {                                                                                 \
+        if (!(condition)) {                                                              \
+            RecordFailure(__FILE__, __LINE__, "CHECK(" #condition ")");                  \
+        }                                                                                \
+    } while (false)
+
+#define CHECK_EQ(actual, expected)                                                       \
+    do {                                                                                 \
+        const auto &actual_value = (actual);                                             \
+        const auto &expected_value = (expected);                                         \
+        if (!(actual_value == expected_value)) {                                         \
+            RecordFailure(__FILE__, __LINE__,                                            \
+                          "CHECK_EQ(" #actual ", " #expected "): got " + std::to_string(actual_value) \
+                              + ", expected " + std::to_string(expected_value));        \
+        }                                                                                \
+    } while (false)
+
+#endif
@@ -0,0 +1,74 @@
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#include "test.h"
+
+namespace {
+
+int g_failures = 0;
+
+} // namespace
+
+std::vector<TestCase> &TestRegistry() {
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+void RecordFailure(const char *file, int line, const std::string &message) {
+    ++g_failures;
+    std::fprintf(stderr, "%s:%d: %s\n", file, line, message.c_str());
+}
+
+std::string TempPath(const std::string &name) {
+    return (std::filesystem::temp_directory_path() / ("gomoku-tests-" + name)).string();
+}
+
+std::vector<unsigned char> ReadBytes(const std::string &path) {
+    std::vector<unsigned char> bytes;
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return bytes;
+    }
+    unsigned char buffer[4096];
+    std::size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        bytes.insert(bytes.end(), buffer, buffer + read);
+    }
+    std::fclose(file);
+    return bytes;
+}
+
+bool WriteBytes(const std::string &path, const std::vector<unsigned char> &bytes) {
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    return std::fclose(file) == 0 && written;
+}
+
+// Runs every test, or only the groups named on the command line. Exits
+// with 1 if any check failed.
+int main(int argc, char **argv) {
+    int run = 0;
+    for (const TestCase &test : TestRegistry()) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i) {
+            selected = selected || test.group == argv[i];
+        }
+        if (!selected) {
+            continue;
+        }
+        int before = g_failures;
+        test.run();
+        ++run;
+        std::printf("%-12s %s/%s\n", g_failures == before ? "ok" : "FAILED", test.group.c_str(), test.name.c_str());
+    }
+    if (run == 0) {
+        std::fprintf(stderr, "no tests selected\n");
+        return 1;
+    }
+    std::printf("%d tests, %d failed checks\n", run, g_failures);
+    return g_failures == 0 ? 0 : 1;
+}